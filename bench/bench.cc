@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cci_logger.hh>
+
+
+/**
+ * @brief Exposes the private formatting stages of a Logger, so each of
+ *        them can be measured on its own.
+ */
+struct LoggerProbe
+{
+    Logger &logger;
+
+    auto time( void ) -> std::string
+    { return logger.get_time(); }
+
+    template<typename... T_Args>
+    auto message( std::string_view p_fmt, const T_Args &...p_args )
+        -> std::string
+    { return Logger::format_message(p_fmt, p_args...); }
+
+    auto pin( void )
+    { return logger.pin_config(); }
+
+    template<typename T_Pin>
+    auto clock( const T_Pin &p_pin ) -> std::chrono::system_clock::time_point
+    { return Logger::now(*p_pin); }
+
+    template<typename... T_Args>
+    auto layout( std::string_view p_fmt, T_Args &&...p_args ) -> std::string
+    { return logger.format(p_fmt, std::forward<T_Args>(p_args)...); }
+
+    void sink( const std::string &p_msg, const bool &p_err )
+    { logger.print_log(p_msg, p_err, 0); }
+};
+
+
+namespace
+{
+    using std::chrono::steady_clock;
+
+
+    /** @brief A stream buffer that accepts and discards everything. */
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        auto overflow( int_type p_ch ) -> int_type override
+        { return traits_type::not_eof(p_ch); }
+
+        auto xsputn( const char * /* p_s */, std::streamsize p_n )
+            -> std::streamsize override
+        { return p_n; }
+    };
+
+
+    /** @brief Keeps the optimiser from discarding @p p_value. */
+    template<typename T>
+    inline void
+    keep( const T &p_value )
+    { asm volatile("" : : "r,m"(p_value) : "memory"); }
+
+
+    struct Result
+    {
+        std::string name;
+        uint64_t    iterations;
+        double      ns_per_op;
+    };
+
+
+    /**
+     * @brief Runs @p p_fn in batches until @p p_budget elapses, five times,
+     *        and returns the median per-call cost.
+     */
+    template<typename T_Fn>
+    auto
+    measure( std::string_view p_name, T_Fn &&p_fn,
+             std::chrono::milliseconds p_budget =
+                std::chrono::milliseconds(100) ) -> Result
+    {
+        constexpr uint64_t BATCH { 256 };
+
+        for (uint64_t i { 0 }; i < BATCH; i++) p_fn(); /* warm-up */
+
+        std::vector<double> samples;
+        uint64_t total { 0 };
+
+        for (int32_t run { 0 }; run < 5; run++) {
+            uint64_t iterations { 0 };
+            steady_clock::time_point start { steady_clock::now() };
+            steady_clock::duration elapsed;
+
+            do {
+                for (uint64_t i { 0 }; i < BATCH; i++) p_fn();
+                iterations += BATCH;
+                elapsed = steady_clock::now() - start;
+            } while (elapsed < p_budget);
+
+            samples.push_back(
+                std::chrono::duration<double, std::nano>(elapsed).count()
+                / static_cast<double>(iterations));
+            total += iterations;
+        }
+
+        std::ranges::sort(samples);
+        return { std::string(p_name), total, samples[samples.size() / 2] };
+    }
+
+
+    void
+    print_json( const std::vector<Result> &p_results )
+    {
+        std::cout << "{\n  \"benchmark\": \"cci_logger\",\n"
+                  << "  \"results\": [\n";
+
+        for (std::size_t i { 0 }; i < p_results.size(); i++) {
+            const Result &r { p_results[i] };
+            std::cout << std::format(
+                "    {{ \"name\": \"{}\", \"iterations\": {}, "
+                "\"ns_per_op\": {:.2f} }}{}\n",
+                r.name, r.iterations, r.ns_per_op,
+                i + 1 < p_results.size() ? "," : "");
+        }
+
+        std::cout << "  ]\n}\n";
+    }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    /* Keep the sink stage honest, but off the terminal. */
+    NullBuffer null;
+    std::streambuf *old_clog { std::clog.rdbuf(&null) };
+    std::streambuf *old_cerr { std::cerr.rdbuf(&null) };
+
+    std::vector<Result> results;
+
+    for (bool coloured : { true, false }) {
+        std::string_view mode { coloured ? "coloured" : "plain" };
+
+        Logger logger { DEBUG };
+        logger.set_coloured_log(coloured);
+        logger.abort_on_error(false);
+
+        LoggerProbe probe { logger };
+        std::string_view layout {
+            coloured ? "[{0} {1} at \033[1m{2}\033[0m( \033[1;30m{3}:{4}"
+                       "\033[0;0m )]: \033[1m{5}\033[0m\n"
+                     : "[{0} {1} at {2}( {3}:{4} )]: {5}\n" };
+        std::string line {
+            "[12:34.567 info at main( bench/bench.cc:42 )]: message\n" };
+
+        auto name = [&]( std::string_view p_what ) -> std::string
+        { return std::format("{}.{}", p_what, mode); };
+
+        results.push_back(measure(name("stage.time_format"), [&]
+        { keep(probe.time()); }));
+
+        results.push_back(measure(name("stage.message_format"), [&]
+        {
+            int32_t     a { 42 };
+            double      b { 3.14 };
+            std::string msg { std::vformat("value {} and {}",
+                                           std::make_format_args(a, b)) };
+            keep(msg);
+        }));
+
+        results.push_back(measure(name("stage.message_format_fast"), [&]
+        {
+            int32_t a { 42 };
+            double  b { 3.14 };
+            keep(probe.message("value {} and {}", a, b));
+        }));
+
+        results.push_back(measure(name("stage.layout_vformat"), [&]
+        {
+            keep(std::vformat(layout, std::make_format_args(
+                 "12:34.567", "info", "main", "bench/bench.cc", "42",
+                 "message")));
+        }));
+
+        results.push_back(measure(name("stage.layout_format"), [&]
+        {
+            keep(probe.layout(layout, "12:34.567", "info", "main",
+                              "bench/bench.cc", "42", "message"));
+        }));
+
+        results.push_back(measure(name("stage.sink_write"), [&]
+        { probe.sink(line, false); }));
+
+        results.push_back(measure(name("log.args0"), [&]
+        { logger.log<INFO>("message"); }));
+
+        results.push_back(measure(name("log.args1"), [&]
+        { logger.log<INFO>("message {}", 1); }));
+
+        results.push_back(measure(name("log.args4"), [&]
+        { logger.log<INFO>("message {} {} {} {}", 1, 2.5, "three", '4'); }));
+
+        results.push_back(measure(name("log.args8"), [&]
+        {
+            logger.log<INFO>("message {} {} {} {} {} {} {} {}",
+                             1, 2.5, "three", '4', 5U, 6L, 7.0F, true);
+        }));
+
+        Logger quiet { WARN };
+        quiet.set_coloured_log(coloured);
+
+        results.push_back(measure(name("log.filtered"), [&]
+        { quiet.log<DEBUG>("message {}", 1); }));
+    }
+
+    using Clock = Logger::Clock;
+    for (auto [clock, label] : {
+             std::pair { Clock::SYSTEM,          "system"          },
+             std::pair { Clock::REALTIME_COARSE, "realtime_coarse" },
+             std::pair { Clock::MONOTONIC_RAW,   "monotonic_raw"   },
+             std::pair { Clock::TSC,             "tsc"             } }) {
+        Logger logger { DEBUG };
+        logger.set_clock(clock);
+
+        /* Pinned once, so only the clock read itself is measured. */
+        LoggerProbe probe { logger };
+        auto pin { probe.pin() };
+        results.push_back(measure(std::format("clock.{}", label), [&]
+        { keep(probe.clock(pin)); }));
+    }
+
+    std::clog.rdbuf(old_clog);
+    std::cerr.rdbuf(old_cerr);
+
+    print_json(results);
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <barrier>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cci_logger.hh>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+
+namespace
+{
+    using std::chrono::steady_clock;
+
+
+    enum class Mode : uint8_t { STDERR, FILE, ASYNC };
+
+    constexpr std::array<std::string_view, 3> MODE_NAMES {
+        "sync_stderr", "file", "async"
+    };
+
+
+    struct Result
+    {
+        Mode        mode;
+        uint32_t    threads;
+        uint64_t    records;
+        double      records_per_sec;
+        double      p50_ns;
+        double      p99_ns;
+        double      p999_ns;
+    };
+
+
+    /** @brief Points fd 2 at /dev/null for as long as the object lives. */
+    class MuteStderr
+    {
+    public:
+        MuteStderr( void ) : m_saved(dup(STDERR_FILENO))
+        {
+            std::cerr.flush();
+            int32_t null { open("/dev/null", O_WRONLY) };
+            dup2(null, STDERR_FILENO);
+            close(null);
+        }
+
+        ~MuteStderr( void )
+        {
+            std::cerr.flush();
+            dup2(m_saved, STDERR_FILENO);
+            close(m_saved);
+        }
+
+        MuteStderr( const MuteStderr & ) = delete;
+        auto operator=( const MuteStderr & ) -> MuteStderr & = delete;
+
+    private:
+        int32_t m_saved;
+    };
+
+
+    auto
+    percentile( const std::vector<uint64_t> &p_sorted, double p_rank )
+        -> double
+    {
+        if (p_sorted.empty()) return 0;
+        auto index { static_cast<std::size_t>(
+                     p_rank * static_cast<double>(p_sorted.size() - 1)) };
+        return static_cast<double>(p_sorted[index]);
+    }
+
+
+    auto
+    run( Mode p_mode, uint32_t p_threads, uint64_t p_per_thread,
+         const std::filesystem::path &p_file ) -> Result
+    {
+        Logger logger { INFO };
+        logger.set_coloured_log(false);
+
+        if (p_mode != Mode::STDERR) {
+            std::filesystem::remove(p_file);
+            logger.set_output_file(p_file.string());
+        }
+        if (p_mode == Mode::ASYNC)
+            logger.set_async(true, p_per_thread * p_threads);
+
+        std::vector<std::vector<uint64_t>> latencies(p_threads);
+        std::vector<std::thread> workers;
+        std::barrier start { p_threads + 1 };
+
+        for (uint32_t t { 0 }; t < p_threads; t++) {
+            workers.emplace_back([&, t]
+            {
+                std::vector<uint64_t> &samples { latencies[t] };
+                samples.reserve(p_per_thread);
+                start.arrive_and_wait();
+
+                for (uint64_t i { 0 }; i < p_per_thread; i++) {
+                    steady_clock::time_point before { steady_clock::now() };
+                    logger.log<INFO>("thread {} record {} value {}",
+                                     t, i, 0.5 * static_cast<double>(i));
+                    samples.push_back(static_cast<uint64_t>(
+                        (steady_clock::now() - before).count()));
+                }
+            });
+        }
+
+        start.arrive_and_wait();
+        steady_clock::time_point begin { steady_clock::now() };
+
+        for (std::thread &worker : workers) worker.join();
+        logger.flush();
+
+        double seconds { std::chrono::duration<double>(
+                         steady_clock::now() - begin).count() };
+
+        std::vector<uint64_t> all;
+        all.reserve(p_per_thread * p_threads);
+        for (const auto &samples : latencies)
+            all.insert(all.end(), samples.begin(), samples.end());
+        std::ranges::sort(all);
+
+        uint64_t records { p_per_thread * p_threads };
+        return {
+            p_mode, p_threads, records,
+            static_cast<double>(records) / seconds,
+            percentile(all, 0.50), percentile(all, 0.99),
+            percentile(all, 0.999)
+        };
+    }
+
+
+    void
+    print_json( const std::vector<Result> &p_results )
+    {
+        std::cout << "{\n  \"benchmark\": \"cci_logger_contention\",\n"
+                  << "  \"results\": [\n";
+
+        for (std::size_t i { 0 }; i < p_results.size(); i++) {
+            const Result &r { p_results[i] };
+            std::cout << std::format(
+                "    {{ \"mode\": \"{}\", \"threads\": {}, \"records\": {}, "
+                "\"records_per_sec\": {:.0f}, \"p50_ns\": {:.0f}, "
+                "\"p99_ns\": {:.0f}, \"p999_ns\": {:.0f} }}{}\n",
+                MODE_NAMES[static_cast<std::size_t>(r.mode)], r.threads,
+                r.records, r.records_per_sec, r.p50_ns, r.p99_ns, r.p999_ns,
+                i + 1 < p_results.size() ? "," : "");
+        }
+
+        std::cout << "  ]\n}\n";
+    }
+}
+
+
+/**
+ * Usage: logger_contention [max threads] [records per thread]
+ */
+auto
+main( int32_t p_argc, char **p_argv ) -> int32_t
+{
+    uint32_t max_threads {
+        p_argc > 1 ? static_cast<uint32_t>(std::stoul(p_argv[1]))
+                   : std::max(1U, std::thread::hardware_concurrency()) };
+    uint64_t per_thread {
+        p_argc > 2 ? std::stoull(p_argv[2]) : 20000 };
+
+    std::filesystem::path file {
+        std::filesystem::temp_directory_path() /
+        std::format("cci_logger_contention_{}.log", getpid()) };
+
+    std::vector<uint32_t> counts;
+    for (uint32_t n { 1 }; n < max_threads; n *= 2) counts.push_back(n);
+    counts.push_back(max_threads);
+
+    std::vector<Result> results;
+    {
+        MuteStderr mute;
+
+        for (Mode mode : { Mode::STDERR, Mode::FILE, Mode::ASYNC })
+            for (uint32_t threads : counts)
+                results.push_back(run(mode, threads, per_thread, file));
+    }
+
+    std::filesystem::remove(file);
+    print_json(results);
+    return 0;
+}
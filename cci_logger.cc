@@ -1,135 +1,3788 @@
+#include <condition_variable>
+#include <unordered_set>
+#include <unordered_map>
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
 #include <iostream>
+#include <charconv>
+#include <cstring>
+#include <bit>
 #include <chrono>
+#include <memory>
+#include <ranges>
+#include <new>
+#include <ctime>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <utility>
+#include <deque>
+#include <mutex>
 #include "cci_logger.hh"
 
 #ifdef _WIN32
     #include <io.h>
+    #include <process.h>
 #elif defined(__unix__) || defined(__APPLE__) || defined(__linux__)
+    #include <sys/socket.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <pthread.h>
     #include <unistd.h>
+    #include <signal.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #ifdef __linux__
+        #include <sys/syscall.h>
+        #include <sched.h>
+    #endif
 #else
     #error "Unsupported platform"
 #endif
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #define CCI_HAS_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define CCI_HAS_TSC
+#endif
+
 
 namespace
 {
+    /* How long shutting down at exit or on abort waits for each output. */
+    constexpr std::chrono::seconds drain_timeout { 1 };
+
+    /* How long fork() waits for the queues, so the parent's records come
+       before the child's; the parent writes whatever is left after. */
+    constexpr std::chrono::milliseconds fork_drain_timeout { 100 };
+
+
+    /** @brief xorshift64*, seeded once per thread. */
+    auto
+    random32( void ) -> uint32_t
+    {
+        thread_local uint64_t state {
+            (static_cast<uint64_t>(std::chrono::steady_clock::now()
+                                   .time_since_epoch().count())
+             ^ std::hash<std::thread::id> {}(std::this_thread::get_id()))
+            | 1 };
+
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return static_cast<uint32_t>((state * 0x2545f4914f6cdd1dULL) >> 32);
+    }
+
+
+    /** @brief A record built on the stack, for async-signal-safe paths. */
+    struct RawRecord
+    {
+        std::array<char, 1024> data;
+        std::size_t            size      { 0 };
+        bool                   truncated { false };
+
+
+        /** @param p_keep Bytes left free for what follows. */
+        void
+        append( std::string_view   p_text,
+                const std::size_t &p_keep = 0 ) noexcept
+        {
+            std::size_t room { data.size() - size };
+            room = room > p_keep ? room - p_keep : 0;
+
+            std::size_t count { std::min(p_text.size(), room) };
+            std::memcpy(data.data() + size, p_text.data(), count);
+            size += count;
+            truncated |= count < p_text.size();
+        }
+
+
+        void
+        append( uint64_t p_value, const std::size_t &p_width = 1 ) noexcept
+        {
+            std::array<char, 20> digits;
+            std::size_t          count { 0 };
+
+            do {
+                digits[count++] = static_cast<char>('0' + p_value % 10);
+                p_value /= 10;
+            } while (p_value != 0 || count < p_width);
+
+            while (count > 0 && size < data.size())
+                data[size++] = digits[--count];
+            truncated |= count > 0;
+        }
+
+
+        [[nodiscard]] auto
+        view( void ) const noexcept -> std::string_view
+        { return { data.data(), size }; }
+    };
+
+
+    /** @brief Writes all of @p p_data with write(2), async-signal-safe. */
+    void
+    write_raw( const int &p_fd, std::string_view p_data ) noexcept
+    {
+        while (!p_data.empty()) {
+#ifdef _WIN32
+            int written { _write(p_fd, p_data.data(),
+                                 static_cast<unsigned>(p_data.size())) };
+#else
+            ssize_t written { write(p_fd, p_data.data(), p_data.size()) };
+            if (written < 0 && errno == EINTR) continue;
+#endif
+            if (written <= 0) return;
+            p_data.remove_prefix(static_cast<std::size_t>(written));
+        }
+    }
+
+
+    inline auto
+    process_id( void ) -> int64_t
+    {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return getpid();
+#endif
+    }
+
+
+    /** @brief Nanoseconds since the epoch, the time records are merged by. */
+    inline auto
+    epoch_ns( void ) -> int64_t
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+
+    /* How long set_sequence_order() waits for late records, once the queue
+       runs dry. */
+    constexpr std::chrono::microseconds reorder_delay { 500 };
+
+
+    /* Counts the fork()s this process descends from, so per-thread caches
+       notice they belong to a thread of the parent. */
+    std::atomic<uint32_t> forks { 0 };
+
+
+    /* The set_thread_name() of each thread. */
+    thread_local std::string thread_name;
+
+
+    /** @brief The system id of the calling thread. */
+    auto
+    thread_id( void ) -> uint64_t
+    {
+#ifdef __linux__
+        thread_local std::pair<uint32_t, uint64_t> cached { UINT32_MAX, 0 };
+
+        uint32_t generation { forks.load(std::memory_order_relaxed) };
+        if (cached.first != generation) [[unlikely]]
+            cached = { generation,
+                       static_cast<uint64_t>(syscall(SYS_gettid)) };
+        return cached.second;
+#else
+        return std::hash<std::thread::id> {}(std::this_thread::get_id());
+#endif
+    }
+
+
+    /** @brief The CPU the calling thread runs on, -1 if unknown. */
+    inline auto
+    current_cpu( void ) -> int32_t
+    {
+#ifdef __linux__
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+
+    /**
+     * @brief Returns a bit per argument index @p p_fmt references, for
+     *        compose() to skip capturing the others.
+     *
+     * "{{" and "}}" are text, and a field's format spec is skipped up to
+     * its closing brace, apart from the nested fields of a dynamic width or
+     * precision, which reference arguments too.
+     */
+    auto
+    format_fields( std::string_view p_fmt ) -> uint32_t
+    {
+        uint32_t    fields { 0 };
+        std::size_t next   { 0 }; /* of automatic "{}" indexing */
+        std::size_t depth  { 0 }; /* of the fields the scan is inside */
+
+        for (std::size_t i { 0 }; i < p_fmt.size(); i++) {
+            bool doubled { i + 1 < p_fmt.size() && p_fmt[i + 1] == p_fmt[i] };
+
+            if (p_fmt[i] == '}') {
+                if (depth > 0) depth--;
+                else if (doubled) i++;
+                continue;
+            }
+            if (p_fmt[i] != '{') continue;
+            if (depth == 0 && doubled) {
+                i++;
+                continue;
+            }
+
+            depth++;
+            const char *start { p_fmt.data() + i + 1 };
+            const char *end   { p_fmt.data() + p_fmt.size() };
+            std::size_t index { 0 };
+
+            auto [last, error] { std::from_chars(start, end, index) };
+            if (error != std::errc {}) {
+                if (start == end || (*start != '}' && *start != ':'))
+                    continue;
+                index = next++;
+            }
+            if (index < 32) fields |= 1U << index;
+            i = static_cast<std::size_t>(last - p_fmt.data()) - 1;
+        }
+        return fields;
+    }
+
+
+    auto
+    read_tsc( void ) -> uint64_t
+    {
+#ifdef CCI_HAS_TSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(
+               std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+
+    auto
+    read_monotonic_raw( void ) -> uint64_t
+    {
+#ifdef __linux__
+        timespec now {};
+        clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL
+             + static_cast<uint64_t>(now.tv_nsec);
+#else
+        return static_cast<uint64_t>(
+               std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+
+    /**
+     * @brief A free-running counter converted to wall time by a multiply-add.
+     *
+     * The rate is measured against the system clock from the first sample
+     * on, so it grows more precise with every re-sync. A re-sync continues
+     * from where the old base leads, and steers towards the system clock
+     * by adjusting the rate for the next 100 ms, never by stepping back.
+     * Readers retry while a re-sync is writing, as in a seqlock. The
+     * counter is a template argument so its read inlines into now_ns().
+     */
+    template<uint64_t (*T_Read)( void )>
+    struct TickClock
+    {
+        std::atomic<uint32_t> version    { 0 };
+        std::atomic<uint64_t> base_ticks { 0 };
+        std::atomic<int64_t>  base_ns    { 0 };
+        std::atomic<double>   ns_per_tick { 1.0 }; /* while steering */
+        std::atomic<double>   measured    { 1.0 }; /* after that */
+        std::atomic<uint64_t> next_sync  { 0 };
+
+        std::mutex sync_lock;
+        uint64_t   first_ticks { 0 };
+        int64_t    first_ns    { 0 };
+        uint64_t   sync_ticks  { 0 }; /* about 100 ms */
+
+        /* Set once calibrated, for fork() to find the sync_lock. */
+        static inline std::atomic<TickClock *> calibrated { nullptr };
+
+
+        TickClock( void )
+        {
+            first_ticks = T_Read();
+            first_ns    = epoch_ns();
+
+            /* A short spin gives a first rate; re-syncs refine it. */
+            int64_t  ns    { first_ns };
+            uint64_t ticks { first_ticks };
+            while (ns - first_ns < 10000000) {
+                ns    = epoch_ns();
+                ticks = T_Read();
+            }
+
+            double rate { static_cast<double>(ns - first_ns)
+                          / static_cast<double>(ticks - first_ticks) };
+            sync_ticks = static_cast<uint64_t>(1e8 / rate);
+            store(ticks, ns, rate, rate);
+            calibrated.store(this);
+        }
+
+
+        /** @brief Publishes a new base. The caller holds sync_lock. */
+        void
+        store( const uint64_t &p_ticks, const int64_t &p_ns,
+               const double &p_rate, const double &p_measured )
+        {
+            version.fetch_add(1, std::memory_order_acq_rel);
+            base_ticks.store(p_ticks, std::memory_order_release);
+            base_ns.store(p_ns, std::memory_order_release);
+            ns_per_tick.store(p_rate, std::memory_order_release);
+            measured.store(p_measured, std::memory_order_release);
+            version.fetch_add(1, std::memory_order_release);
+
+            next_sync.store(p_ticks + sync_ticks, std::memory_order_relaxed);
+        }
+
+
+        void
+        sync( void )
+        {
+            std::unique_lock lock { sync_lock, std::try_to_lock };
+            if (!lock.owns_lock()) return;
+
+            uint64_t ticks { T_Read() };
+            int64_t  ns    { epoch_ns() };
+            if (ticks <= first_ticks) return;
+
+            double rate { static_cast<double>(ns - first_ns)
+                          / static_cast<double>(ticks - first_ticks) };
+
+            /* Lagging behind is caught up within sync_ticks, running ahead
+               is worked off at no less than half the rate. */
+            int64_t lead  { convert(ticks) };
+            double  steer { rate + static_cast<double>(ns - lead)
+                                   / static_cast<double>(sync_ticks) };
+            store(ticks, lead, std::max(steer, rate / 2), rate);
+        }
+
+
+        /** @brief Converts @p p_ticks with the current base. */
+        auto
+        convert( const uint64_t &p_ticks ) -> int64_t
+        {
+            while (true) {
+                uint32_t version_before {
+                    version.load(std::memory_order_acquire) };
+
+                /* Acquire keeps the version check below after these. */
+                uint64_t base  { base_ticks.load(std::memory_order_acquire) };
+                int64_t  ns    { base_ns.load(std::memory_order_acquire) };
+                double   steer { ns_per_tick.load(std::memory_order_acquire) };
+                double   rate  { measured.load(std::memory_order_acquire) };
+
+                if ((version_before & 1) != 0
+                 || version.load(std::memory_order_relaxed) != version_before)
+                    continue;
+
+                /* Ticks read before a concurrent re-sync may precede base. */
+                if (p_ticks < base)
+                    return ns - static_cast<int64_t>(
+                                static_cast<double>(base - p_ticks) * steer);
+
+                uint64_t delta   { p_ticks - base };
+                uint64_t steered { std::min(delta, sync_ticks) };
+                return ns + static_cast<int64_t>(
+                            static_cast<double>(steered) * steer
+                          + static_cast<double>(delta - steered) * rate);
+            }
+        }
+
+
+        /** @brief One counter read; convert() allows for a re-sync after. */
+        auto
+        now_ns( void ) -> int64_t
+        {
+            uint64_t ticks { T_Read() };
+            if (ticks >= next_sync.load(std::memory_order_relaxed))
+                [[unlikely]] sync();
+
+            return convert(ticks);
+        }
+    };
+
+
+    /** @brief Calibrated on first use, which set_clock() makes early. */
+    template<uint64_t (*T_Read)( void )>
+    auto
+    tick_clock( void ) -> TickClock<T_Read> &
+    {
+        static TickClock<T_Read> clock;
+        return clock;
+    }
+
+
+#ifndef _WIN32
+    /* The sync_locks lock_tick_clocks() took. */
+    std::array<std::mutex *, 2> locked_clocks {};
+
+
+    /**
+     * @brief Takes the re-sync lock of each calibrated clock before fork(),
+     *        so the child does not inherit a base half published, which
+     *        its readers would retry forever.
+     */
+    void
+    lock_tick_clocks( void )
+    {
+        auto *tsc { TickClock<read_tsc>::calibrated.load() };
+        auto *raw { TickClock<read_monotonic_raw>::calibrated.load() };
+
+        locked_clocks = { tsc != nullptr ? &tsc->sync_lock : nullptr,
+                          raw != nullptr ? &raw->sync_lock : nullptr };
+        for (std::mutex *lock : locked_clocks)
+            if (lock != nullptr) lock->lock();
+    }
+
+
+    void
+    unlock_tick_clocks( void )
+    {
+        for (std::mutex *lock : locked_clocks)
+            if (lock != nullptr) lock->unlock();
+    }
+#endif
+
+
+    /* Starts every set_thread_output() segment. */
+    constexpr std::string_view segment_magic { "CCISEG1\n" };
+
+
+    /** @brief Frames a record in a segment, followed by its text. */
+    struct SegmentRecord
+    {
+        int64_t  time;
+        uint64_t sequence;
+        uint64_t size;
+    };
+
+
     inline auto
     is_stdin_available( void ) -> bool
     { return isatty(fileno(stdin)); }
 
 
+    /* "00" to "99", for writing two digits at a time. */
+    constexpr std::array<char, 200> digit_pairs { []
+    {
+        std::array<char, 200> pairs {};
+        for (std::size_t i { 0 }; i < 100; i++) {
+            pairs[2 * i]     = static_cast<char>('0' + i / 10);
+            pairs[2 * i + 1] = static_cast<char>('0' + i % 10);
+        }
+        return pairs;
+    }() };
+
+
+    /**
+     * @brief Writes @p p_value in decimal, zero padded to @p p_width digits,
+     *        to the end of @p p_end.
+     * @return Where the digits start.
+     */
+    inline auto
+    put_digits( char *p_end, uint64_t p_value, const std::size_t &p_width )
+        -> char *
+    {
+        char *pos { p_end };
+
+        while (p_value >= 100) {
+            pos -= 2;
+            std::memcpy(pos, &digit_pairs[(p_value % 100) * 2], 2);
+            p_value /= 100;
+        }
+        if (p_value >= 10) {
+            pos -= 2;
+            std::memcpy(pos, &digit_pairs[p_value * 2], 2);
+        } else *--pos = static_cast<char>('0' + p_value);
+
+        while (static_cast<std::size_t>(p_end - pos) < p_width) *--pos = '0';
+        return pos;
+    }
+
+
+    /** @brief Appends @p p_value, zero padded to @p p_width digits. */
+    inline void
+    append_digits( std::string &p_out, const uint64_t &p_value,
+                   const std::size_t &p_width )
+    {
+        std::array<char, 20> buffer;
+        char *end { buffer.data() + buffer.size() };
+        p_out.append(put_digits(end, p_value, p_width), end);
+    }
+
+
+    /** @brief The local calendar time of a second, and its UTC offset. */
+    struct LocalTime
+    {
+        std::time_t second { -1 };
+        tm          calendar {};
+        int64_t     offset { 0 }; /* seconds east of UTC */
+    };
+
+
+    /**
+     * @brief Returns the local time of @p p_second, converting it only once
+     *        per second and thread.
+     */
+    auto
+    local_time( const std::time_t &p_second ) -> const LocalTime &
+    {
+        thread_local LocalTime cached;
+        if (cached.second == p_second) [[likely]] return cached;
+
+        cached.second = p_second;
+#ifdef _WIN32
+        localtime_s(&cached.calendar, &p_second);
+        tm utc { cached.calendar };
+        cached.offset = static_cast<int64_t>(_mkgmtime(&utc) - p_second);
+#else
+        localtime_r(&p_second, &cached.calendar);
+        cached.offset = cached.calendar.tm_gmtoff;
+#endif
+        return cached;
+    }
+
+
+    /**
+     * @brief Formats @p p_time after @p p_fmt; see Logger::set_time_format()
+     *        for the tokens.
+     */
     auto
-    format_time( std::string_view p_fmt ) -> std::string
+    format_time( std::string_view                             p_fmt,
+                 const std::chrono::system_clock::time_point &p_time )
+        -> std::string
     {
         using namespace std::chrono;
 
-        time_point now { std::chrono::system_clock::now() };
-        std::time_t time { std::chrono::system_clock::to_time_t(now) };
-        tm tm { *std::localtime(&time) };
+        int64_t epoch { duration_cast<nanoseconds>(
+                        p_time.time_since_epoch()).count() };
+        int64_t second { epoch / 1000000000 };
+        int64_t ns     { epoch % 1000000000 };
+        if (ns < 0) {
+            second--;
+            ns += 1000000000;
+        }
+
+        const LocalTime &local { local_time(static_cast<std::time_t>(second)) };
+        const tm        &tm    { local.calendar };
 
-        auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
+        auto put_date = [&tm]( std::string &p_out )
+        {
+            append_digits(p_out, static_cast<uint64_t>(tm.tm_year + 1900), 4);
+            p_out += '-';
+            append_digits(p_out, static_cast<uint64_t>(tm.tm_mon + 1), 2);
+            p_out += '-';
+            append_digits(p_out, static_cast<uint64_t>(tm.tm_mday), 2);
+        };
 
-        std::ostringstream out;
+        std::string out;
+        out.reserve(p_fmt.size() + 32);
 
         while (!p_fmt.empty()) {
-            if (p_fmt[0] == '%' && p_fmt.size() >= 2) {
-                if (p_fmt.substr(0, 3) == "%MS") {
-                    out << std::setw(3) << std::setfill('0') << ms.count();
-                    p_fmt.remove_prefix(3);
-                } else if (p_fmt.substr(0, 2) == "%S") {
-                    out << std::setw(2) << std::setfill('0') << tm.tm_sec;
-                    p_fmt.remove_prefix(2);
-                } else if (p_fmt.substr(0, 2) == "%M") {
-                    out << std::setw(2) << std::setfill('0') << tm.tm_min;
-                    p_fmt.remove_prefix(2);
-                } else if (p_fmt.substr(0, 2) == "%H") {
-                    out << std::setw(2) << std::setfill('0') << tm.tm_hour;
-                    p_fmt.remove_prefix(2);
-                } else if (p_fmt.substr(0, 2) == "%D") {
-                    out << std::put_time(&tm, "%Y-%m-%d");
-                    p_fmt.remove_prefix(2);
-                } else {
-                    out << p_fmt[0];
-                    p_fmt.remove_prefix(1);
-                }
+            auto take = [&p_fmt]( std::string_view p_token )
+            {
+                if (!p_fmt.starts_with(p_token)) return false;
+                p_fmt.remove_prefix(p_token.size());
+                return true;
+            };
+
+            if (p_fmt[0] != '%') {
+                out += p_fmt[0];
+                p_fmt.remove_prefix(1);
+            } else if (take("%MS")) {
+                append_digits(out, static_cast<uint64_t>(ns / 1000000), 3);
+            } else if (take("%US")) {
+                append_digits(out, static_cast<uint64_t>(ns / 1000), 6);
+            } else if (take("%NS")) {
+                append_digits(out, static_cast<uint64_t>(ns), 9);
+            } else if (take("%EMS")) {
+                append_digits(out, static_cast<uint64_t>(epoch / 1000000), 1);
+            } else if (take("%EUS")) {
+                append_digits(out, static_cast<uint64_t>(epoch / 1000), 1);
+            } else if (take("%ENS")) {
+                append_digits(out, static_cast<uint64_t>(epoch), 1);
+            } else if (take("%ES")) {
+                append_digits(out, static_cast<uint64_t>(second), 1);
+            } else if (take("%ISO")) {
+                put_date(out);
+                out += 'T';
+                append_digits(out, static_cast<uint64_t>(tm.tm_hour), 2);
+                out += ':';
+                append_digits(out, static_cast<uint64_t>(tm.tm_min), 2);
+                out += ':';
+                append_digits(out, static_cast<uint64_t>(tm.tm_sec), 2);
+                out += '.';
+                append_digits(out, static_cast<uint64_t>(ns / 1000), 6);
+
+                int64_t offset { local.offset / 60 };
+                out += offset < 0 ? '-' : '+';
+                offset = offset < 0 ? -offset : offset;
+                append_digits(out, static_cast<uint64_t>(offset / 60), 2);
+                out += ':';
+                append_digits(out, static_cast<uint64_t>(offset % 60), 2);
+            } else if (take("%S")) {
+                append_digits(out, static_cast<uint64_t>(tm.tm_sec), 2);
+            } else if (take("%M")) {
+                append_digits(out, static_cast<uint64_t>(tm.tm_min), 2);
+            } else if (take("%H")) {
+                append_digits(out, static_cast<uint64_t>(tm.tm_hour), 2);
+            } else if (take("%D")) {
+                put_date(out);
             } else {
-                out << p_fmt[0];
+                out += p_fmt[0];
                 p_fmt.remove_prefix(1);
             }
         }
 
-        return out.str();
+        return out;
     }
 }
 
 
-Logger::Logger( const LogLevel &p_loglevel ) :
-    m_threshold_level(p_loglevel),
-    m_time_format("%M:%S.%MS"),
-    m_coloured(true),
-    m_ask_continue(true),
-    m_abort_on_err(true)
-{}
+#ifndef _WIN32
+namespace
+{
+    /**
+     * @brief Header of a shared memory ring, followed by its data.
+     *
+     * Producers reserve space by moving head forward with a CAS, copy their
+     * record in, then publish it by setting the committed bit of its first
+     * word. The collector, the only consumer, reads committed records from
+     * tail, zeroes them and moves tail forward, so space a producer has not
+     * written yet always reads as uncommitted.
+     */
+    struct SharedRing
+    {
+        static constexpr uint64_t MAGIC { 0x0263636972696e67 }; /* v2 */
 
+        static constexpr uint32_t COMMITTED { 1U << 31 };
+        static constexpr uint32_t PADDING   { 1U << 30 };
+        static constexpr uint32_t LENGTH    { PADDING - 1 };
 
-void
-Logger::set_time_format( const std::string &p_fmt )
-{ m_time_format = p_fmt; }
+        /* Record layout: state, message size, then the timestamp. */
+        static constexpr std::size_t RECORD_HEADER { 16 };
 
+        static_assert(std::atomic<uint64_t>::is_always_lock_free);
 
-void
-Logger::set_log_format( const std::string &p_fmt )
-{ m_log_format = p_fmt; }
+        std::atomic<uint64_t> magic;
+        uint64_t              capacity; /* a power of two */
+        int64_t               pid;
 
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+        std::atomic<uint64_t>             dropped;
+        std::atomic<uint32_t>             closed; /* by its process */
 
-void
-Logger::set_log_format( void )
-{ m_log_format.clear(); }
 
+        auto
+        data( void ) -> unsigned char *
+        { return reinterpret_cast<unsigned char *>(this + 1); }
 
-void
-Logger::abort_on_error( const bool &p_abort )
-{ m_abort_on_err = p_abort; }
 
+        auto
+        state( const uint64_t &p_offset ) -> std::atomic_ref<uint32_t>
+        {
+            return std::atomic_ref<uint32_t> {
+                *reinterpret_cast<uint32_t *>(data() + p_offset) };
+        }
 
-void
-Logger::ask_continue_on_error( const bool &p_ask )
-{ m_ask_continue = p_ask; }
 
+        /** @return False if the ring is full, and the record was dropped. */
+        auto
+        push( std::string_view p_msg, const int64_t &p_time ) -> bool
+        {
+            uint64_t total { (RECORD_HEADER + p_msg.size() + 7) & ~7ULL };
+            uint64_t at    { head.load(std::memory_order_relaxed) };
+            uint64_t offset, skip;
 
-void
-Logger::set_coloured_log( const bool &p_coloured )
-{ m_coloured = p_coloured; }
+            /* A record is never split, the end of the data is skipped. */
+            do {
+                offset = at & (capacity - 1);
+                skip   = capacity - offset < total ? capacity - offset : 0;
 
+                if (total > capacity / 2 || at + skip + total
+                    - tail.load(std::memory_order_acquire) > capacity) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            } while (!head.compare_exchange_weak(at, at + skip + total,
+                                                 std::memory_order_relaxed));
 
-auto
-Logger::get_time( void ) -> std::string
-{
-    return format_time(m_time_format);
+            if (skip != 0) {
+                state(offset).store(static_cast<uint32_t>(skip) | COMMITTED
+                                    | PADDING, std::memory_order_release);
+                offset = 0;
+            }
+
+            auto size { static_cast<uint32_t>(p_msg.size()) };
+            std::memcpy(data() + offset + 4, &size, sizeof(size));
+            std::memcpy(data() + offset + 8, &p_time, sizeof(p_time));
+            std::memcpy(data() + offset + RECORD_HEADER, p_msg.data(),
+                        p_msg.size());
+
+            state(offset).store(static_cast<uint32_t>(total) | COMMITTED,
+                                std::memory_order_release);
+            return true;
+        }
+
+
+        /** @brief Hands every committed record to @p p_read, oldest first. */
+        template<typename T_Read>
+        void
+        drain( T_Read &&p_read )
+        {
+            uint64_t at { tail.load(std::memory_order_relaxed) };
+
+            while (true) {
+                uint64_t offset { at & (capacity - 1) };
+                uint32_t word   { state(offset).load(
+                                  std::memory_order_acquire) };
+                if ((word & COMMITTED) == 0) break;
+
+                if ((word & PADDING) == 0) {
+                    uint32_t size;
+                    int64_t  time;
+                    std::memcpy(&size, data() + offset + 4, sizeof(size));
+                    std::memcpy(&time, data() + offset + 8, sizeof(time));
+
+                    p_read(time, std::string_view {
+                        reinterpret_cast<const char *>(data() + offset
+                                                       + RECORD_HEADER),
+                        size });
+                }
+
+                std::memset(data() + offset, 0, word & LENGTH);
+                at += word & LENGTH;
+                tail.store(at, std::memory_order_release);
+            }
+        }
+    };
+
+
+    /** @brief A mapped ring, and the name it was opened by. */
+    struct RingMapping
+    {
+        std::string  name;
+        SharedRing  *ring;
+        std::size_t  size;
+    };
 }
+#endif
 
 
-auto
-Logger::ask_continue( void ) -> bool
+namespace
 {
-    if (!is_stdin_available()) return false;
-    std::string line;
+    /** @brief The thread running Logger::housekeep(). */
+    struct Housekeeper
+    {
+        std::mutex              lock;
+        std::condition_variable wake;
+        std::thread             thread;
+        bool                    stopping { false };
+    };
+    Housekeeper housekeeper;
 
-    while (true) {
-        std::cerr << "An error has occured, do you want to continue? [y/N] ";
-        std::getline(std::cin, line);
+    constexpr std::chrono::milliseconds housekeeping_tick { 100 };
 
-        if (line.empty()) return false;
 
-        char answ { static_cast<char>(std::tolower(line.at(0))) };
-        if (answ == 'y') return true;
-        if (answ == 'n') return false;
+    /* set_call_sites() overrides in order, guarding site registration. */
+    std::mutex                                           site_filter_lock;
+    std::vector<std::pair<Logger::CallSiteFilter, bool>> site_filters;
 
-        std::cerr << "Please enter y or n.\n";
-    }
+    /* Guards the named Logger registry of Logger::get(). */
+    std::mutex registry_lock;
 }
 
 
-void
-Logger::print_log( const std::string &p_msg, const bool &p_err )
-{ (p_err ? std::cerr : std::clog) << p_msg; }
\ No newline at end of file
+/** @brief The last record of an output, and how often it repeated. */
+struct Logger::Repeats
+{
+    std::mutex  lock;
+    uint64_t    hash  { 0 };
+    uint64_t    count { 0 };
+    CallSite   *site  { nullptr };
+    LogLevel    level { DEBUG };
+    std::string msg;
+
+    std::chrono::steady_clock::time_point since;
+};
+
+
+/**
+ * @brief Everything a Logger shares with its copies: the published
+ *        configurations, and where formatted records end up, stdout/stderr
+ *        or a file, written either by the logging thread or by a background
+ *        writer.
+ */
+struct Logger::Backend : Shared
+{
+    struct Record
+    {
+        std::string msg;
+        bool        err;
+        uint64_t    sequence;
+    };
+
+    std::mutex        write_lock;
+    std::FILE        *file { nullptr };
+    std::atomic<bool> to_file { false };
+    std::atomic<int>  fd      { -1 }; /* of file, for signal handlers */
+
+    std::array<Repeats, 2> repeats;
+
+    std::atomic<uint64_t> errors { 0 }; /* for ErrorPolicy::abort_after */
+
+    /* Counted here, as signal handlers can not attach Counters. */
+    std::atomic<uint64_t> truncated { 0 };
+
+    /* Records over the rate limit, by call site with s_overflow_site last,
+       allocated when the first one is suppressed. */
+    std::atomic<std::atomic<uint64_t> *> suppressed { nullptr };
+
+    const std::chrono::steady_clock::time_point start {
+        std::chrono::steady_clock::now() };
+
+#ifndef _WIN32
+    /* Replaced rings stay mapped, as a producer may still be copying into
+       them. */
+    std::atomic<SharedRing *> ring { nullptr };
+    std::vector<RingMapping>  rings;     /* under write_lock */
+    std::string               ring_name; /* under write_lock */
+#endif
+
+    /** @brief Offered load of a sampled level, for adaptive sampling. */
+    struct SampleWindow
+    {
+        std::atomic<uint64_t> second { 0 };
+        std::atomic<uint64_t> count  { 0 };
+        std::atomic<uint64_t> scale  { 1ULL << 32 }; /* 1.0 */
+    };
+    std::array<SampleWindow, __LOG_LEVEL_AMOUNT> sample_windows;
+
+    std::mutex              queue_lock;
+    std::condition_variable queue_cv;
+    std::condition_variable drained_cv;
+    std::deque<Record>      queue;
+    std::size_t             capacity { 0 };
+    bool                    running  { false };
+    bool                    writing  { false };
+    bool                    stopping { false };
+    bool                    detached { false }; /* a writer given up on */
+    std::size_t             reorder_window { 0 };
+
+    std::mutex  writer_lock; /* serialises starting and stopping */
+    std::thread writer;
+
+    /** @brief A set_thread_output() file, only written by its thread. */
+    struct Segment
+    {
+        std::FILE         *file; /* nullptr once retired */
+        uint64_t           generation;
+        uint64_t           sequence { 0 };
+        std::atomic<bool>  busy     { false }; /* while its thread writes */
+    };
+
+    /* Changed by every set_thread_output(), 0 for the shared output. */
+    std::atomic<uint64_t>                 segment_generation { 0 };
+    std::mutex                            segments_lock;
+    uint64_t                              generations { 0 }; /* handed out */
+    std::size_t                           segments_opened { 0 };
+    std::string                           segment_prefix;
+    std::vector<std::unique_ptr<Segment>> segments;
+
+    std::mutex               backtrace_lock;
+    std::deque<std::string>  backtrace;
+    std::atomic<std::size_t> backtrace_capacity { 0 };
+
+    std::mutex                             counters_lock;
+    std::vector<std::unique_ptr<Counters>> counters;
+
+    /* Replaced snapshots wait in retired until no thread pins them. */
+    std::mutex                                 config_lock;
+    std::unique_ptr<const Config>              current;
+    std::vector<std::unique_ptr<const Config>> retired;
+
+
+    /* Every Backend alive, for shutting them down at exit. */
+    static inline std::mutex live_lock;
+
+    /**
+     * @brief The Backends alive. Never freed, as a Logger of another
+     *        translation unit may outlive this one's statics.
+     */
+    static auto
+    live( void ) -> std::vector<Backend *> &
+    {
+        static auto *backends { new std::vector<Backend *> };
+        return *backends;
+    }
+
+
+    Backend( void )
+    {
+        static std::atomic<uint64_t> next_id { 1 };
+        id = next_id.fetch_add(1, std::memory_order_relaxed);
+        publish(std::make_unique<Config>());
+
+        static std::once_flag at_exit;
+        std::call_once(at_exit, []
+        {
+            std::atexit([]{
+                shutdown_all(std::chrono::steady_clock::now() + drain_timeout);
+            });
+#ifndef _WIN32
+            pthread_atfork(Logger::before_fork, Logger::after_fork_parent,
+                           Logger::after_fork_child);
+#endif
+        });
+
+        std::scoped_lock lock { live_lock };
+        live().push_back(this);
+    }
+
+
+    /**
+     * @brief Makes @p p_config current, and frees the replaced snapshots no
+     *        thread pins anymore. The caller holds config_lock.
+     */
+    void
+    publish( std::unique_ptr<const Config> p_config )
+    {
+        config.store(p_config.get());
+        if (current != nullptr) retired.push_back(std::move(current));
+        current = std::move(p_config);
+
+        std::scoped_lock lock { counters_lock };
+        std::erase_if(retired, [this]( const auto &p_retired )
+        {
+            return std::ranges::none_of(counters, [&]( const auto &p_counters )
+                   { return p_counters->pinned.load() == p_retired.get(); });
+        });
+    }
+
+
+    ~Backend( void )
+    {
+        {
+            std::scoped_lock lock { live_lock };
+            std::erase(live(), this);
+        }
+
+        stop_writer();
+        delete[] suppressed.load();
+        if (file != nullptr) std::fclose(file);
+        for (const auto &segment : segments)
+            if (segment->file != nullptr) std::fclose(segment->file);
+
+#ifndef _WIN32
+        close_rings();
+        for (const RingMapping &mapping : rings)
+            munmap(mapping.ring, mapping.size);
+#endif
+    }
+
+
+    auto
+    suppressed_counts( void ) -> std::atomic<uint64_t> *
+    {
+        std::atomic<uint64_t> *counts { suppressed.load() };
+        if (counts != nullptr) [[likely]] return counts;
+
+        auto *fresh { new std::atomic<uint64_t>[m_CALL_SITE_CAPACITY + 1] {} };
+        if (suppressed.compare_exchange_strong(counts, fresh)) return fresh;
+
+        delete[] fresh;
+        return counts;
+    }
+
+
+#ifndef _WIN32
+    /**
+     * @brief Creates this process' ring of @p p_name and makes it the
+     *        output. The caller holds write_lock.
+     * @return False, with errno set, if the ring could not be mapped.
+     */
+    auto
+    open_ring( const std::string &p_name, const std::size_t &p_capacity )
+        -> bool
+    {
+        std::string name { std::format("/{}.{}", p_name, getpid()) };
+        std::size_t size { sizeof(SharedRing) + p_capacity };
+
+        int fd { shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600) };
+        void *map { MAP_FAILED };
+
+        if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) == 0)
+            map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+
+        if (map == MAP_FAILED) {
+            int error { errno };
+            if (fd >= 0) {
+                close(fd);
+                shm_unlink(name.c_str());
+            }
+            errno = error;
+            return false;
+        }
+        close(fd);
+
+        /* The collector ignores the ring until the magic is published. */
+        auto *shared { new (map) SharedRing };
+        shared->capacity = p_capacity;
+        shared->pid      = getpid();
+        shared->magic.store(SharedRing::MAGIC, std::memory_order_release);
+
+        rings.push_back({ name, shared, size });
+        ring_name = p_name;
+        ring.store(shared, std::memory_order_release);
+        return true;
+    }
+
+
+    /**
+     * @brief Marks this process' rings closed, and removes those that hold
+     *        no records; a Collector removes the others once it drained
+     *        them. The caller holds write_lock, or destroys the Backend.
+     */
+    void
+    close_rings( void )
+    {
+        std::vector<std::string_view> seen;
+
+        /* A name opened again belongs to its newest ring. */
+        for (const RingMapping &mapping : rings | std::views::reverse) {
+            SharedRing &shared { *mapping.ring };
+            if (shared.pid != getpid()) continue;
+            shared.closed.store(1, std::memory_order_release);
+
+            if (std::ranges::find(seen, mapping.name) != seen.end()) continue;
+            seen.push_back(mapping.name);
+
+            if (shared.head.load(std::memory_order_acquire)
+                    == shared.tail.load(std::memory_order_acquire))
+                shm_unlink(mapping.name.c_str());
+        }
+    }
+#endif
+
+
+    void
+    write( const std::string &p_msg, const bool &p_err )
+    {
+        std::scoped_lock lock { write_lock };
+
+        if (file != nullptr)
+            std::fwrite(p_msg.data(), 1, p_msg.size(), file);
+        else
+            (p_err ? std::cerr : std::clog) << p_msg;
+    }
+
+
+    /**
+     * @brief Returns the calling thread's segment of @p p_generation,
+     *        opening it if needed.
+     * @return The segment, or nullptr if it could not be opened.
+     */
+    auto
+    get_segment( const uint64_t &p_generation ) -> Segment *
+    {
+        struct Attached
+        {
+            uint64_t generation;
+            Segment *segment;
+        };
+
+        /* Backend ids are never reused, so stale entries are harmless. */
+        thread_local std::unordered_map<uint64_t, Attached> attached;
+        thread_local std::pair<uint64_t, Attached>          last;
+
+        if (last.first == id && last.second.generation == p_generation)
+            [[likely]] return last.second.segment;
+
+        Attached &entry { attached[id] };
+        if (entry.generation != p_generation) {
+            std::scoped_lock lock { segments_lock };
+            if (segment_generation.load() != p_generation) return nullptr;
+
+            std::string path { std::format("{}.{}.{}.seg", segment_prefix,
+                                           process_id(), segments_opened++) };
+            std::FILE *file { std::fopen(path.c_str(), "wb") };
+            if (file == nullptr) return nullptr;
+
+            std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+            std::fwrite(segment_magic.data(), 1, segment_magic.size(), file);
+
+            entry = { p_generation, segments.emplace_back(
+                      std::make_unique<Segment>(file, p_generation)).get() };
+        }
+
+        last = { id, entry };
+        return entry.segment;
+    }
+
+
+    /**
+     * @param p_time When the record was logged, in epoch nanoseconds.
+     * @return False if the record was dropped.
+     */
+    auto
+    write_segment( std::string_view p_msg, const uint64_t &p_generation,
+                   const int64_t &p_time ) -> bool
+    {
+        Segment *segment { get_segment(p_generation) };
+        if (segment == nullptr) return false;
+
+        /* Set before the generation is checked again, so retire_segments()
+           either waits for this write or is seen here. */
+        segment->busy.store(true);
+        bool current { segment_generation.load() == p_generation };
+
+        if (current) {
+            SegmentRecord record { p_time, segment->sequence++,
+                                   p_msg.size() };
+            std::fwrite(&record, sizeof(record), 1, segment->file);
+            std::fwrite(p_msg.data(), 1, p_msg.size(), segment->file);
+        }
+
+        segment->busy.store(false, std::memory_order_release);
+        return current;
+    }
+
+
+    /**
+     * @brief Closes the segments of earlier generations once their thread
+     *        is done writing. The caller holds segments_lock.
+     */
+    void
+    retire_segments( void )
+    {
+        uint64_t generation { segment_generation.load() };
+
+        for (const auto &segment : segments) {
+            if (segment->file == nullptr || segment->generation == generation)
+                continue;
+
+            while (segment->busy.load()) std::this_thread::yield();
+            std::fclose(segment->file);
+            segment->file = nullptr;
+        }
+    }
+
+
+    void
+    flush_segments( void )
+    {
+        std::scoped_lock lock { segments_lock };
+        for (const auto &segment : segments)
+            if (segment->file != nullptr) std::fflush(segment->file);
+    }
+
+
+    /** @return False if the record was dropped. */
+    auto
+    submit( std::string &&p_msg, const bool &p_err,
+            const uint64_t &p_sequence, const int64_t &p_time ) -> bool
+    {
+        if (uint64_t generation {
+                segment_generation.load(std::memory_order_acquire) })
+            return write_segment(p_msg, generation,
+                                 p_time != 0 ? p_time : epoch_ns());
+
+#ifndef _WIN32
+        if (SharedRing *shared { ring.load(std::memory_order_acquire) })
+            return shared->push(p_msg, p_time != 0 ? p_time : epoch_ns());
+#endif
+
+        {
+            std::scoped_lock lock { queue_lock };
+            if (running) {
+                if (queue.size() >= capacity) return false;
+
+                queue.emplace_back(std::move(p_msg), p_err, p_sequence);
+                queue_cv.notify_one();
+                return true;
+            }
+        }
+
+        write(p_msg, p_err);
+        return true;
+    }
+
+
+    void
+    run( void )
+    {
+        std::deque<Record>  batch;
+        std::vector<Record> pending; /* min-heap on sequence */
+        std::unique_lock    lock { queue_lock };
+
+        auto later = []( const Record &p_a, const Record &p_b )
+        { return p_a.sequence > p_b.sequence; };
+
+        auto write_first = [&]
+        {
+            std::ranges::pop_heap(pending, later);
+            write(pending.back().msg, pending.back().err);
+            pending.pop_back();
+        };
+
+        while (true) {
+            queue_cv.wait(lock, [this]{ return stopping || !queue.empty(); });
+            if (queue.empty() && stopping) break;
+
+            batch.swap(queue);
+            writing = true;
+            std::size_t window { reorder_window };
+            lock.unlock();
+
+            for (Record &record : batch) {
+                if (window == 0 && pending.empty()) {
+                    write(record.msg, record.err);
+                    continue;
+                }
+
+                pending.push_back(std::move(record));
+                std::ranges::push_heap(pending, later);
+                if (pending.size() > window) write_first();
+            }
+            batch.clear();
+
+            /* Late records get a moment to arrive, then nothing is held back
+               once the queue runs dry, so flush() and shutdown() still see
+               every record written. */
+            lock.lock();
+            if (queue.empty() && !pending.empty())
+                queue_cv.wait_for(lock, reorder_delay, [this]
+                                  { return stopping || !queue.empty(); });
+            if (queue.empty() && !pending.empty()) {
+                lock.unlock();
+                while (!pending.empty()) write_first();
+                lock.lock();
+            }
+
+            writing = false;
+            drained_cv.notify_all();
+        }
+
+        detached = false;
+    }
+
+
+    void
+    start_writer( const std::size_t &p_capacity )
+    {
+        std::scoped_lock control { writer_lock };
+        std::scoped_lock lock    { queue_lock };
+
+        /* A writer shutdown() gave up on still runs on stopping, so a new
+           one waits until it has finished. */
+        capacity = p_capacity;
+        if (running || detached) return;
+
+        running  = true;
+        stopping = false;
+        writer   = std::thread { &Backend::run, this };
+    }
+
+
+    void
+    stop_writer( void )
+    {
+        std::scoped_lock control { writer_lock };
+        {
+            std::scoped_lock lock { queue_lock };
+            if (!running) return;
+
+            running  = false;
+            stopping = true;
+            queue_cv.notify_one();
+        }
+
+        writer.join();
+    }
+
+
+    void
+    remember( const std::string &p_msg )
+    {
+        std::scoped_lock lock { backtrace_lock };
+
+        std::size_t capacity {
+            backtrace_capacity.load(std::memory_order_relaxed) };
+        while (backtrace.size() >= capacity && !backtrace.empty())
+            backtrace.pop_front();
+        if (capacity != 0) backtrace.push_back(p_msg);
+    }
+
+
+    /**
+     * @brief Writes out the file buffer and the queued records from a signal
+     *        handler. Locks held at the time of the signal are skipped, as
+     *        their holder may never release them.
+     */
+    void
+    salvage( void ) noexcept
+    {
+        int output { fd.load() < 0 ? 2 : fd.load() };
+
+        /* Every stdio call on the file is made under write_lock. */
+        if (write_lock.try_lock()) {
+            if (file != nullptr) std::fflush(file);
+            write_lock.unlock();
+        }
+
+        if (queue_lock.try_lock()) {
+            for (const Record &record : queue) write_raw(output, record.msg);
+            queue_lock.unlock();
+        }
+    }
+
+
+    /**
+     * @brief Replays the backtrace ring to stderr from a signal handler,
+     *        unless records are written there already; salvage() has put
+     *        every one of them in the output by then.
+     */
+    void
+    salvage_backtrace( void ) noexcept
+    {
+        bool elsewhere { fd.load() >= 0 || segment_generation.load() != 0 };
+#ifndef _WIN32
+        elsewhere = elsewhere || ring.load() != nullptr;
+#endif
+        if (!elsewhere) return;
+
+        if (backtrace_lock.try_lock()) {
+            for (const std::string &record : backtrace) write_raw(2, record);
+            backtrace_lock.unlock();
+        }
+    }
+
+
+    /**
+     * @brief Drains the queue and stops the writer, waiting no longer than
+     *        @p p_deadline.
+     * @return False if the queue was not drained in time.
+     */
+    auto
+    shutdown( const std::chrono::steady_clock::time_point &p_deadline )
+        -> bool
+    {
+        std::scoped_lock control { writer_lock };
+        bool             drained { true };
+        bool             stopped { false };
+
+        {
+            std::unique_lock lock { queue_lock };
+            if (running) {
+                drained = drained_cv.wait_until(lock, p_deadline, [this]
+                          { return queue.empty() && !writing; });
+
+                running  = false;
+                stopping = true;
+                stopped  = true;
+                detached = !drained;
+                queue_cv.notify_one();
+            }
+        }
+
+        if (!drained) {
+            /* The writer is stuck, likely on the output. It keeps the
+               backend alive until the process ends. */
+            refs.fetch_add(1, std::memory_order_relaxed);
+            writer.detach();
+            return false;
+        }
+
+        if (stopped) writer.join();
+        flush_segments();
+
+        std::scoped_lock lock { write_lock };
+        if (file != nullptr) std::fflush(file);
+        else std::clog.flush();
+        return true;
+    }
+
+
+    static void
+    shutdown_all( const std::chrono::steady_clock::time_point &p_deadline )
+    {
+        housekeep(true);
+
+        std::scoped_lock lock { live_lock };
+        for (Backend *backend : live()) {
+            backend->shutdown(p_deadline);
+#ifndef _WIN32
+            std::scoped_lock rings { backend->write_lock };
+            backend->close_rings();
+#endif
+        }
+    }
+
+
+#ifndef _WIN32
+    /**
+     * @brief Drains the queue and takes every lock of each backend and
+     *        tick clock, so the child of a fork() gets them in a consistent
+     *        state and does not inherit buffered output. The queues are
+     *        waited on for fork_drain_timeout in all.
+     */
+    static void
+    lock_all( void )
+    {
+        auto deadline {
+            std::chrono::steady_clock::now() + fork_drain_timeout };
+        live_lock.lock();
+
+        /* In the order the logging paths nest them. */
+        for (Backend *backend : live()) {
+            backend->writer_lock.lock();
+            for (Repeats &last : backend->repeats) last.lock.lock();
+
+            std::unique_lock queue { backend->queue_lock };
+            backend->drained_cv.wait_until(queue, deadline, [backend]
+            { return backend->queue.empty() && !backend->writing; });
+            queue.release();
+
+            backend->write_lock.lock();
+            if (backend->file != nullptr) std::fflush(backend->file);
+
+            backend->segments_lock.lock();
+            for (const auto &segment : backend->segments)
+                if (segment->file != nullptr) std::fflush(segment->file);
+
+            backend->backtrace_lock.lock();
+            backend->config_lock.lock();
+            backend->counters_lock.lock();
+        }
+
+        lock_tick_clocks();
+    }
+
+
+    void
+    unlock_after_fork( void )
+    {
+        counters_lock.unlock();
+        config_lock.unlock();
+        backtrace_lock.unlock();
+        segments_lock.unlock();
+        write_lock.unlock();
+        queue_lock.unlock();
+        for (Repeats &last : repeats) last.lock.unlock();
+        writer_lock.unlock();
+    }
+
+
+    static void
+    unlock_all( void )
+    {
+        unlock_tick_clocks();
+        for (Backend *backend : live()) backend->unlock_after_fork();
+        live_lock.unlock();
+    }
+
+
+    /**
+     * @brief Restarts the writer threads in the child of a fork(), which
+     *        they do not survive, and releases the locks lock_all() took.
+     *        The records still queued are the parent's to write.
+     */
+    static void
+    reset_all( void )
+    {
+        unlock_tick_clocks();
+        for (Backend *backend : live()) {
+            backend->queue.clear();
+            backend->writing  = false;
+            backend->detached = false;
+
+            /* The old handle names a thread of the parent, and the condition
+               variables may count its waits; none of them can be destroyed,
+               only written over. */
+            new (&backend->queue_cv)   std::condition_variable;
+            new (&backend->drained_cv) std::condition_variable;
+
+            /* Segments are named after the process, the child opens its
+               own; closing the parent's would write their buffers twice. */
+            for (auto &segment : backend->segments) segment.release();
+            backend->segments.clear();
+            if (backend->segment_generation.load() != 0)
+                backend->segment_generation.store(++backend->generations);
+            if (backend->running)
+                new (&backend->writer) std::thread { &Backend::run, backend };
+
+            /* The parent's ring goes away with the parent, the child logs
+               into one of its own, or to the other outputs if it can not. */
+            if (SharedRing *ring { backend->ring.load() })
+                if (!backend->open_ring(backend->ring_name, ring->capacity))
+                    backend->ring.store(nullptr);
+
+            backend->unlock_after_fork();
+        }
+
+        live_lock.unlock();
+    }
+#endif
+
+
+    void
+    flush( void )
+    {
+        {
+            std::unique_lock lock { queue_lock };
+            drained_cv.wait(lock, [this]{ return queue.empty() && !writing; });
+        }
+
+        flush_segments();
+
+        std::scoped_lock lock { write_lock };
+        if (file != nullptr) std::fflush(file);
+        else {
+            std::cerr.flush();
+            std::clog.flush();
+        }
+    }
+};
+
+
+std::array<Logger::LevelNode, __LOG_LEVEL_AMOUNT> Logger::s_fixed_levels {{
+    { 0, DEBUG, nullptr, {} }, { 0, INFO,  nullptr, {} },
+    { 0, WARN,  nullptr, {} }, { 0, ERROR, nullptr, {} }
+}};
+
+
+Logger::Logger( const LogLevel &p_loglevel ) :
+    m_shared(new Backend),
+    m_level(&s_fixed_levels[p_loglevel])
+{}
+
+
+Logger::Logger( Shared *p_shared ) :
+    m_shared(p_shared),
+    m_level(&s_fixed_levels[DEBUG])
+{}
+
+
+Logger::Logger( const Logger &p_other ) :
+    m_shared(p_other.m_shared),
+    m_level(p_other.m_level)
+{ m_shared->refs.fetch_add(1, std::memory_order_relaxed); }
+
+
+auto
+Logger::operator=( const Logger &p_other ) -> Logger &
+{
+    Logger copy { p_other };
+    std::swap(m_shared, copy.m_shared);
+    m_level = p_other.m_level;
+    return *this;
+}
+
+
+Logger::~Logger( void )
+{
+    if (m_shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        flush_repeats();
+        report_suppressed();
+        delete &backend();
+    }
+}
+
+
+auto
+Logger::backend( void ) const -> Backend &
+{ return *static_cast<Backend *>(m_shared); }
+
+
+void
+Logger::set_level( const LogLevel &p_loglevel )
+{ m_level = &s_fixed_levels[p_loglevel]; }
+
+
+auto
+Logger::get( const std::string &p_name ) -> Logger
+{
+    static Logger root { WARN };
+    static std::unordered_map<std::string, std::unique_ptr<LevelNode>> nodes;
+
+    std::scoped_lock guard { registry_lock };
+
+    /* Create the missing entries from the root down: "", "net", ... */
+    LevelNode  *parent { nullptr };
+    std::size_t end    { 0 };
+
+    while (true) {
+        std::string name { p_name.substr(0, end) };
+
+        auto &node { nodes[name] };
+        if (node == nullptr) {
+            node         = std::make_unique<LevelNode>();
+            node->name   = name;
+            node->parent = parent;
+            if (parent == nullptr) node->level = WARN;
+        }
+
+        parent = node.get();
+        if (end >= p_name.size()) break;
+        end = std::min(p_name.find('.', end + 1), p_name.size());
+    }
+
+    Logger named { root };
+    named.m_level = parent;
+    return named;
+}
+
+
+void
+Logger::set_level( const std::string &p_name, const LogLevel &p_loglevel )
+{
+    Logger named { get(p_name) };
+    named.m_level->level.store(p_loglevel);
+    s_level_generation.fetch_add(1);
+}
+
+
+void
+Logger::reset_level( const std::string &p_name )
+{
+    Logger named { get(p_name) };
+    if (named.m_level->parent == nullptr) return; /* the root keeps one */
+
+    named.m_level->level.store(-1);
+    s_level_generation.fetch_add(1);
+}
+
+
+auto
+Logger::resolve_level( LevelNode &p_node ) -> uint64_t
+{
+    /* Read the generation first: a change during the walk leaves the cache
+       stale, so the next call walks again. */
+    uint64_t generation { s_level_generation.load() };
+
+    const LevelNode *node { &p_node };
+    while (node->level.load() < 0 && node->parent != nullptr)
+        node = node->parent;
+
+    uint64_t cache { generation << 8
+                   | static_cast<uint64_t>(std::max(node->level.load(), 0)) };
+    p_node.cache.store(cache, std::memory_order_relaxed);
+    return cache;
+}
+
+
+void
+Logger::update_config( const std::function<void( Config & )> &p_update )
+{
+    std::scoped_lock lock { backend().config_lock };
+
+    auto config { std::make_unique<Config>(*backend().current) };
+    p_update(*config);
+    backend().publish(std::move(config));
+}
+
+
+void
+Logger::set_time_format( const std::string &p_fmt )
+{ update_config([&]( Config &p_config ) { p_config.time_format = p_fmt; }); }
+
+
+void
+Logger::set_log_format( const std::string &p_fmt )
+{
+    update_config([&]( Config &p_config )
+    {
+        p_config.log_format = p_fmt;
+        p_config.fields     = format_fields(p_fmt);
+    });
+}
+
+
+void
+Logger::set_log_format( void )
+{
+    update_config([]( Config &p_config )
+    {
+        p_config.log_format.clear();
+        p_config.fields = Config {}.fields;
+    });
+}
+
+
+void
+Logger::set_clock( const Clock &p_clock )
+{
+    if (p_clock == Clock::MONOTONIC_RAW) tick_clock<read_monotonic_raw>();
+    if (p_clock == Clock::TSC)           tick_clock<read_tsc>();
+    update_config([&]( Config &p_config ) { p_config.clock = p_clock; });
+}
+
+
+void
+Logger::set_thread_name( const std::string &p_name )
+{ thread_name = p_name; }
+
+
+void
+Logger::set_sampling( const LogLevel &p_level, const Sampling &p_sampling )
+{
+    double probability { std::clamp(p_sampling.probability, 0.0, 1.0) };
+
+    SamplePolicy policy {
+        .active    = p_sampling.every > 1 || probability < 1.0
+                  || p_sampling.budget != 0,
+        .every     = std::max(p_sampling.every, 1U),
+        .threshold = static_cast<uint64_t>(probability * 4294967296.0),
+        .budget    = p_sampling.budget
+    };
+
+    update_config([&]( Config &p_config )
+    { p_config.sampling[p_level] = policy; });
+}
+
+
+void
+Logger::set_sampling( const LogLevel &p_level )
+{
+    update_config([&]( Config &p_config )
+    { p_config.sampling[p_level] = {}; });
+}
+
+
+void
+Logger::abort_on_error( const bool &p_abort )
+{ update_config([&]( Config &p_config ) { p_config.abort_on_err = p_abort; }); }
+
+
+void
+Logger::ask_continue_on_error( const bool &p_ask )
+{ update_config([&]( Config &p_config ) { p_config.ask_continue = p_ask; }); }
+
+
+void
+Logger::set_error_policy( const ErrorPolicy &p_policy )
+{
+    update_config([&]( Config &p_config )
+    { p_config.error_policy = p_policy; });
+}
+
+
+void
+Logger::set_error_policy( void )
+{ update_config([]( Config &p_config ) { p_config.error_policy = {}; }); }
+
+
+void
+Logger::set_coloured_log( const bool &p_coloured )
+{ update_config([&]( Config &p_config ) { p_config.coloured = p_coloured; }); }
+
+
+void
+Logger::collapse_repeats( const bool                      &p_collapse,
+                          const std::chrono::milliseconds &p_timeout )
+{
+    if (!p_collapse) flush_repeats();
+
+    update_config([&]( Config &p_config )
+    {
+        p_config.collapse_repeats = p_collapse;
+        p_config.repeat_timeout   = p_timeout;
+    });
+
+    if (p_collapse) start_housekeeping();
+}
+
+
+void
+Logger::set_output_file( const std::string &p_path )
+{
+    std::FILE *file { nullptr };
+
+    if (!p_path.empty()) {
+        file = std::fopen(p_path.c_str(), "a");
+        if (file == nullptr)
+            throw std::runtime_error { std::format(
+                "Failed to open log file {}: {}", p_path,
+                std::strerror(errno)) };
+    }
+
+    flush();
+
+    std::scoped_lock lock { backend().write_lock };
+    if (backend().file != nullptr) std::fclose(backend().file);
+    backend().file = file;
+    backend().to_file.store(file != nullptr);
+    backend().fd.store(file != nullptr ? fileno(file) : -1);
+}
+
+
+void
+Logger::set_shared_memory_output( const std::string &p_name,
+                                  const std::size_t &p_capacity )
+{
+#ifdef _WIN32
+    throw std::runtime_error { std::format(
+        "Failed to open shared memory ring {}: not supported", p_name) };
+#else
+    flush();
+
+    /* The Collector removes the replaced ring once it drained it. */
+    std::scoped_lock lock { backend().write_lock };
+    if (SharedRing *replaced { backend().ring.load() })
+        replaced->closed.store(1, std::memory_order_release);
+
+    if (p_name.empty()) {
+        backend().ring.store(nullptr);
+        return;
+    }
+
+    if (!backend().open_ring(p_name, std::bit_ceil(
+                             std::max<std::size_t>(p_capacity, 4096))))
+        throw std::runtime_error { std::format(
+            "Failed to open shared memory ring /{}.{}: {}", p_name, getpid(),
+            std::strerror(errno)) };
+#endif
+}
+
+
+void
+Logger::set_thread_output( const std::string &p_prefix )
+{
+    flush();
+
+    uint64_t generation { 0 };
+    {
+        std::scoped_lock lock { backend().segments_lock };
+        backend().segment_prefix = p_prefix;
+
+        /* Never reused, so no thread takes a retired segment for current. */
+        if (!p_prefix.empty()) generation = ++backend().generations;
+        backend().segment_generation.store(generation);
+        backend().retire_segments();
+    }
+
+    if (generation != 0 && backend().get_segment(generation) == nullptr)
+        throw std::runtime_error { std::format(
+            "Failed to open log segment {}.{}: {}", p_prefix, process_id(),
+            std::strerror(errno)) };
+}
+
+
+auto
+Logger::merge_thread_outputs( const std::vector<std::string> &p_paths,
+                              std::FILE                      *p_output )
+    -> std::size_t
+{
+    struct Reader
+    {
+        std::unique_ptr<std::FILE, int (*)( std::FILE * )> file;
+        SegmentRecord                                      record;
+        std::string                                        text;
+
+
+        /** @return False at the end, or at a record cut short. */
+        auto
+        next( void ) -> bool
+        {
+            if (std::fread(&record, sizeof(record), 1, file.get()) != 1)
+                return false;
+
+            text.resize(record.size);
+            return std::fread(text.data(), 1, text.size(), file.get())
+                == text.size();
+        }
+    };
+
+    std::vector<Reader> readers;
+    readers.reserve(p_paths.size());
+
+    for (const std::string &path : p_paths) {
+        Reader &reader { readers.emplace_back(Reader {
+            { std::fopen(path.c_str(), "rb"), std::fclose }, {}, {} }) };
+
+        std::array<char, segment_magic.size()> magic {};
+        if (reader.file == nullptr
+         || std::fread(magic.data(), 1, magic.size(), reader.file.get())
+                != magic.size()
+         || std::string_view { magic.data(), magic.size() } != segment_magic)
+            throw std::runtime_error { std::format(
+                "Failed to read log segment {}: {}", path,
+                reader.file == nullptr ? std::strerror(errno)
+                                       : "not a segment") };
+    }
+
+    auto later = [&readers]( const std::size_t &p_a, const std::size_t &p_b )
+    {
+        const SegmentRecord &a { readers[p_a].record };
+        const SegmentRecord &b { readers[p_b].record };
+        return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+    };
+
+    std::vector<std::size_t> heap;
+    for (std::size_t i { 0 }; i < readers.size(); i++)
+        if (readers[i].next()) heap.push_back(i);
+    std::ranges::make_heap(heap, later);
+
+    std::size_t written { 0 };
+    while (!heap.empty()) {
+        std::ranges::pop_heap(heap, later);
+        Reader &reader { readers[heap.back()] };
+
+        std::fwrite(reader.text.data(), 1, reader.text.size(), p_output);
+        written++;
+
+        if (reader.next()) std::ranges::push_heap(heap, later);
+        else               heap.pop_back();
+    }
+
+    return written;
+}
+
+
+struct Logger::Collector::State
+{
+    std::string              prefix; /* "<name>." */
+    std::chrono::nanoseconds window;
+
+#ifndef _WIN32
+    std::vector<RingMapping> rings {};
+#endif
+
+    /* Drained records not yet written, by timestamp. */
+    std::vector<std::pair<int64_t, std::string>> pending {};
+
+
+    /** @brief Maps the rings created since the last call. */
+    void
+    discover( void )
+    {
+#ifndef _WIN32
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator {
+                 "/dev/shm", error }) {
+            std::string name { entry.path().filename().string() };
+            if (!name.starts_with(prefix)) continue;
+
+            name.insert(0, "/");
+            if (std::ranges::any_of(rings, [&name]( const RingMapping &p_ring )
+                                    { return p_ring.name == name; }))
+                continue;
+
+            int fd { shm_open(name.c_str(), O_RDWR, 0) };
+            if (fd < 0) continue;
+
+            struct stat info {};
+            void *map { MAP_FAILED };
+            if (fstat(fd, &info) == 0
+             && static_cast<std::size_t>(info.st_size) > sizeof(SharedRing))
+                map = mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                           PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (map == MAP_FAILED) continue;
+
+            auto *ring { static_cast<SharedRing *>(map) };
+            auto  size { static_cast<std::size_t>(info.st_size) };
+
+            /* Not set up yet, try again on the next poll. */
+            if (ring->magic.load(std::memory_order_acquire)
+                    != SharedRing::MAGIC
+             || sizeof(SharedRing) + ring->capacity != size) {
+                munmap(map, size);
+                continue;
+            }
+
+            rings.push_back({ name, ring, size });
+        }
+#endif
+    }
+
+
+    /** @brief Drains every ring, and removes those of exited processes
+     *         and those their process closed. */
+    void
+    drain( void )
+    {
+#ifndef _WIN32
+        std::erase_if(rings, [this]( const RingMapping &p_ring )
+        {
+            /* Checked first, so records written before exiting are in. */
+            bool exited { kill(static_cast<pid_t>(p_ring.ring->pid), 0) != 0
+                       && errno == ESRCH };
+
+            bool closed { p_ring.ring->closed.load(
+                          std::memory_order_acquire) != 0 };
+
+            p_ring.ring->drain([this]( int64_t p_time, std::string_view p_msg )
+            { pending.emplace_back(p_time, p_msg); });
+
+            if (!exited && !closed) return false;
+
+            munmap(p_ring.ring, p_ring.size);
+            shm_unlink(p_ring.name.c_str());
+            return true;
+        });
+#endif
+    }
+
+
+    /** @brief Writes the pending records up to @p p_until, in order. */
+    auto
+    write( std::FILE *p_output, const int64_t &p_until ) -> std::size_t
+    {
+        std::ranges::stable_sort(pending, {},
+                                 &std::pair<int64_t, std::string>::first);
+
+        auto end { std::ranges::find_if(pending, [&p_until]( const auto &p_rec )
+                                        { return p_rec.first > p_until; }) };
+
+        for (auto record { pending.begin() }; record != end; record++)
+            std::fwrite(record->second.data(), 1, record->second.size(),
+                        p_output);
+        std::fflush(p_output);
+
+        auto written { static_cast<std::size_t>(end - pending.begin()) };
+        pending.erase(pending.begin(), end);
+        return written;
+    }
+};
+
+
+Logger::Collector::Collector( const std::string               &p_name,
+                              const std::chrono::milliseconds &p_window ) :
+    m_state(new State { .prefix = p_name + ".", .window = p_window })
+{}
+
+
+Logger::Collector::~Collector( void )
+{
+#ifndef _WIN32
+    for (const RingMapping &mapping : m_state->rings)
+        munmap(mapping.ring, mapping.size);
+#endif
+    delete m_state;
+}
+
+
+auto
+Logger::Collector::poll( std::FILE *p_output ) -> std::size_t
+{
+    m_state->discover();
+    m_state->drain();
+
+    auto now { std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()) };
+    return m_state->write(p_output, (now - m_state->window).count());
+}
+
+
+auto
+Logger::Collector::finish( std::FILE *p_output ) -> std::size_t
+{
+    m_state->discover();
+    m_state->drain();
+    return m_state->write(p_output, INT64_MAX);
+}
+
+
+void
+Logger::set_async( const bool &p_async, const std::size_t &p_capacity )
+{
+    if (p_async) backend().start_writer(p_capacity);
+    else         backend().stop_writer();
+}
+
+
+void
+Logger::set_sequence_order( const std::size_t &p_window )
+{
+    update_config([&]( Config &p_config )
+    { p_config.ordered = p_window != 0; });
+
+    std::scoped_lock lock { backend().queue_lock };
+    backend().reorder_window = p_window;
+}
+
+
+void
+Logger::flush( void )
+{
+    flush_repeats();
+    report_suppressed();
+    backend().flush();
+}
+
+
+auto
+Logger::shutdown( const std::chrono::milliseconds &p_timeout ) -> bool
+{
+    flush_repeats();
+    report_suppressed();
+    return backend().shutdown(std::chrono::steady_clock::now() + p_timeout);
+}
+
+
+void
+Logger::set_backtrace( const std::size_t &p_capacity )
+{
+    std::scoped_lock lock { backend().backtrace_lock };
+    backend().backtrace_capacity.store(p_capacity);
+
+    while (backend().backtrace.size() > p_capacity)
+        backend().backtrace.pop_front();
+}
+
+
+void
+Logger::snapshot( const std::string &p_path )
+{
+    flush();
+
+    std::deque<std::string> records;
+    {
+        std::scoped_lock lock { backend().backtrace_lock };
+        records = backend().backtrace;
+    }
+
+    std::FILE *file { std::fopen(p_path.c_str(), "w") };
+    if (file == nullptr)
+        throw std::runtime_error { std::format(
+            "Failed to open snapshot file {}: {}", p_path,
+            std::strerror(errno)) };
+
+    for (const std::string &record : records)
+        std::fwrite(record.data(), 1, record.size(), file);
+    std::fclose(file);
+}
+
+
+#ifndef _WIN32
+namespace
+{
+    /**
+     * @brief Loggers to snapshot, by signal. Never freed, since the thread
+     *        serving them is never joined.
+     */
+    struct SignalSnapshots
+    {
+        std::mutex                                              lock;
+        std::unordered_map<int, std::pair<Logger, std::string>> loggers;
+        std::array<int, 2>                                      pipe;
+    };
+
+    /* Written before the first handler is installed, and again by the child
+       of a fork(). */
+    int signal_pipe { -1 };
+
+    /* Set by the first snapshot_on_signal(), for fork() to find. */
+    std::atomic<SignalSnapshots *> snapshots { nullptr };
+
+
+    void
+    on_snapshot_signal( int p_signal )
+    {
+        int           saved  { errno };
+        unsigned char signal { static_cast<unsigned char>(p_signal) };
+
+        /* The pipe is non-blocking, a full one already has work queued. */
+        ssize_t written { write(signal_pipe, &signal, 1) };
+        static_cast<void>(written);
+        errno = saved;
+    }
+
+
+    void
+    run_signal_snapshots( SignalSnapshots &p_state )
+    {
+        while (true) {
+            unsigned char signal;
+            ssize_t       size { read(p_state.pipe[0], &signal, 1) };
+            if (size < 0 && errno == EINTR) continue;
+            if (size <= 0) return;
+
+            std::optional<std::pair<Logger, std::string>> entry;
+            {
+                std::scoped_lock lock { p_state.lock };
+                auto found { p_state.loggers.find(signal) };
+                if (found == p_state.loggers.end()) continue;
+                entry.emplace(found->second);
+            }
+
+            std::string path { std::format(
+                "{}-{}.log", entry->second,
+                format_time("%D-%H%M%S.%MS",
+                            std::chrono::system_clock::now())) };
+
+            try {
+                entry->first.snapshot(path);
+            } catch (const std::exception &e) {
+                std::cerr << std::format("Failed to snapshot on signal {}: "
+                                         "{}\n", signal, e.what());
+            }
+        }
+    }
+
+
+    auto
+    start_signal_snapshots( void ) -> SignalSnapshots &
+    {
+        auto *state { new SignalSnapshots };
+
+        if (pipe(state->pipe.data()) != 0) {
+            int error { errno };
+            delete state;
+            throw std::runtime_error { std::format(
+                "Failed to set up signal snapshots: {}",
+                std::strerror(error)) };
+        }
+
+        fcntl(state->pipe[1], F_SETFL, O_NONBLOCK);
+        signal_pipe = state->pipe[1];
+        snapshots.store(state);
+
+        std::thread { run_signal_snapshots, std::ref(*state) }.detach();
+        return *state;
+    }
+}
+#endif
+
+
+void
+Logger::snapshot_on_signal( const int &p_signal, const std::string &p_prefix )
+{
+#ifdef _WIN32
+    throw std::runtime_error { std::format(
+        "Failed to snapshot on signal {}: not supported", p_signal) };
+#else
+    static SignalSnapshots &state { start_signal_snapshots() };
+    {
+        std::scoped_lock lock { state.lock };
+        state.loggers.insert_or_assign(p_signal, std::pair { *this, p_prefix });
+    }
+
+    struct sigaction action {};
+    action.sa_handler = on_snapshot_signal;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(p_signal, &action, nullptr) != 0)
+        throw std::runtime_error { std::format(
+            "Failed to snapshot on signal {}: {}", p_signal,
+            std::strerror(errno)) };
+#endif
+}
+
+
+void
+Logger::log_signal_safe( const LogLevel   &p_level,
+                         std::string_view  p_msg ) noexcept
+{
+    if (p_level < threshold()) return;
+
+    int saved { errno };
+
+#ifdef _WIN32
+    std::timespec now {};
+    std::timespec_get(&now, TIME_UTC);
+#else
+    timespec now {};
+    clock_gettime(CLOCK_REALTIME, &now);
+#endif
+
+    RawRecord record;
+    record.append("[");
+    record.append(static_cast<uint64_t>(now.tv_sec));
+    record.append(".");
+    record.append(static_cast<uint64_t>(now.tv_nsec / 1000000), 3);
+    record.append(" ");
+    record.append(m_LOG_LABELS[p_level].second);
+    record.append("]: ");
+    record.append(p_msg, 1);
+    record.append("\n");
+
+    if (record.truncated)
+        backend().truncated.fetch_add(1, std::memory_order_relaxed);
+
+    int fd { backend().fd.load() };
+    write_raw(fd < 0 ? 2 : fd, record.view());
+    errno = saved;
+}
+
+
+#ifndef _WIN32
+namespace
+{
+    /* Handles are leaked, as a handler may be using the previous one. */
+    std::atomic<Logger *> crash_logger { nullptr };
+
+    constexpr std::array crash_signals {
+        std::pair { SIGSEGV, std::string_view { "SIGSEGV" } },
+        std::pair { SIGBUS,  std::string_view { "SIGBUS"  } },
+        std::pair { SIGFPE,  std::string_view { "SIGFPE"  } },
+        std::pair { SIGILL,  std::string_view { "SIGILL"  } },
+        std::pair { SIGABRT, std::string_view { "SIGABRT" } },
+    };
+}
+#endif
+
+
+void
+Logger::on_crash_signal( int p_signal )
+{
+#ifndef _WIN32
+    Logger *logger { crash_logger.load() };
+
+    if (logger != nullptr) {
+        RawRecord message;
+        message.append("caught ");
+        for (const auto &[signal, name] : crash_signals)
+            if (signal == p_signal) message.append(name);
+
+        logger->backend().salvage();
+        logger->log_signal_safe(ERROR, message.view());
+        logger->backend().salvage_backtrace();
+    }
+
+    /* SA_RESETHAND restored the default action, which this delivers once
+       the handler returns. */
+    raise(p_signal);
+#else
+    static_cast<void>(p_signal);
+#endif
+}
+
+
+void
+Logger::flush_on_crash( void )
+{
+#ifdef _WIN32
+    throw std::runtime_error { "Failed to flush on crash: not supported" };
+#else
+    crash_logger.store(new Logger { *this });
+
+    for (const auto &[signal, name] : crash_signals) {
+        struct sigaction action {};
+        action.sa_handler = on_crash_signal;
+        action.sa_flags   = SA_RESETHAND;
+        sigemptyset(&action.sa_mask);
+
+        if (sigaction(signal, &action, nullptr) != 0)
+            throw std::runtime_error { std::format(
+                "Failed to handle {}: {}", name, std::strerror(errno)) };
+    }
+#endif
+}
+
+
+auto
+Logger::stats( void ) const -> Stats
+{
+    constexpr auto load = []( const std::atomic<uint64_t> &p_counter )
+    { return p_counter.load(std::memory_order_relaxed); };
+
+    Stats stats;
+    std::scoped_lock lock { backend().counters_lock };
+
+    for (const auto &counters : backend().counters) {
+        for (std::size_t i { 0 }; i < stats.records.size(); i++)
+            stats.records[i] += load(counters->records[i]);
+
+        stats.filtered   += load(counters->filtered);
+        stats.bytes      += load(counters->bytes);
+        stats.dropped    += load(counters->dropped);
+        stats.limited    += load(counters->limited);
+        stats.collapsed  += load(counters->collapsed);
+        stats.sampled    += load(counters->sampled);
+        stats.print_time += std::chrono::nanoseconds(load(counters->print_ns));
+    }
+    stats.truncated = load(backend().truncated);
+
+    return stats;
+}
+
+
+auto
+Logger::attach_counters( void ) -> Counters &
+{
+    /* Backend ids are never reused, so stale entries are harmless. */
+    thread_local std::unordered_map<uint64_t, Counters *> attached;
+
+    Counters *&counters { attached[m_shared->id] };
+    if (counters == nullptr) {
+        std::scoped_lock lock { backend().counters_lock };
+        counters = backend().counters.emplace_back(
+                   std::make_unique<Counters>()).get();
+    }
+
+    return *counters;
+}
+
+
+auto
+Logger::get_time( const std::chrono::system_clock::time_point &p_time )
+    -> std::string
+{
+    return format_time(pin_config()->time_format, p_time);
+}
+
+
+auto
+Logger::now( const Config &p_config ) -> std::chrono::system_clock::time_point
+{
+    using namespace std::chrono;
+
+    switch (p_config.clock) {
+    case Clock::SYSTEM:
+        break;
+
+    case Clock::REALTIME_COARSE: {
+#ifdef __linux__
+        timespec now {};
+        clock_gettime(CLOCK_REALTIME_COARSE, &now);
+        return system_clock::time_point { duration_cast<
+               system_clock::duration>(seconds(now.tv_sec)
+                                       + nanoseconds(now.tv_nsec)) };
+#else
+        break;
+#endif
+    }
+
+    /* Not cheaper than SYSTEM, which is the same vDSO call; these trade a
+       little time for a source NTP does not slew. */
+    case Clock::MONOTONIC_RAW:
+        return system_clock::time_point { duration_cast<
+               system_clock::duration>(nanoseconds(
+               tick_clock<read_monotonic_raw>().now_ns())) };
+
+    case Clock::TSC:
+        return system_clock::time_point { duration_cast<
+               system_clock::duration>(nanoseconds(
+               tick_clock<read_tsc>().now_ns())) };
+    }
+
+    return system_clock::now();
+}
+
+
+auto
+Logger::record_time( const Config &p_config )
+    -> std::chrono::system_clock::time_point
+{
+    bool stamped { (p_config.fields >> FIELD_TIME & 1) != 0
+                || backend().segment_generation.load(
+                       std::memory_order_relaxed) != 0 };
+#ifndef _WIN32
+    stamped = stamped
+           || backend().ring.load(std::memory_order_relaxed) != nullptr;
+#endif
+    return stamped ? now(p_config) : std::chrono::system_clock::time_point {};
+}
+
+
+auto
+Logger::format_fast( std::string_view   p_fmt,
+                     const FastArg     *p_args,
+                     const std::size_t &p_count,
+                     std::string       &p_out ) -> bool
+{
+    p_out.reserve(p_fmt.size() + 16 * p_count);
+
+    std::size_t next      { 0 };
+    bool        automatic { false };
+    bool        manual    { false };
+
+    while (!p_fmt.empty()) {
+        std::size_t brace { p_fmt.find_first_of("{}") };
+        p_out.append(p_fmt.substr(0, brace));
+        if (brace == std::string_view::npos) break;
+        p_fmt.remove_prefix(brace);
+
+        if (p_fmt.size() >= 2 && p_fmt[1] == p_fmt[0]) {
+            p_out += p_fmt[0];
+            p_fmt.remove_prefix(2);
+            continue;
+        }
+        if (p_fmt[0] == '}') return false;
+
+        std::size_t close { p_fmt.find('}') };
+        if (close == std::string_view::npos) return false;
+
+        std::string_view field { p_fmt.substr(1, close - 1) };
+        std::size_t      index { 0 };
+        if (field.empty()) {
+            index     = next++;
+            automatic = true;
+        } else {
+            const char *end { field.data() + field.size() };
+            auto [ptr, error] = std::from_chars(field.data(), end, index);
+            if (error != std::errc {} || ptr != end) return false;
+            manual = true;
+        }
+        if ((automatic && manual) || index >= p_count) return false;
+        p_fmt.remove_prefix(close + 1);
+
+        const FastArg       &arg { p_args[index] };
+        std::array<char, 32> buffer;
+        char *end { buffer.data() + buffer.size() };
+
+        switch (arg.kind) {
+        case FastArg::SIGNED: {
+            uint64_t magnitude { arg.i < 0 ? 0 - static_cast<uint64_t>(arg.i)
+                                           : static_cast<uint64_t>(arg.i) };
+            char *start { put_digits(end, magnitude, 1) };
+            if (arg.i < 0) *--start = '-';
+            p_out.append(start, end);
+            break;
+        }
+        case FastArg::UNSIGNED:
+            p_out.append(put_digits(end, arg.u, 1), end);
+            break;
+        case FastArg::FLOAT:
+            p_out.append(buffer.data(),
+                         std::to_chars(buffer.data(), end, arg.f).ptr);
+            break;
+        case FastArg::DOUBLE:
+            p_out.append(buffer.data(),
+                         std::to_chars(buffer.data(), end, arg.d).ptr);
+            break;
+        case FastArg::BOOL:
+            p_out.append(arg.b ? "true" : "false");
+            break;
+        case FastArg::CHAR:
+            p_out += arg.c;
+            break;
+        case FastArg::STRING:
+            p_out.append(arg.text);
+            break;
+        case FastArg::POINTER:
+            p_out.append("0x");
+            p_out.append(buffer.data(), std::to_chars(
+                buffer.data(), end, reinterpret_cast<uintptr_t>(arg.p),
+                16).ptr);
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+auto
+Logger::compose( const Config     &p_config,
+                 const LogLevel   &p_level,
+                 std::string_view  p_file,
+                 std::string_view  p_function,
+                 const uint32_t   &p_line,
+                 std::string_view  p_msg,
+                 const uint64_t   &p_sequence,
+                 const std::chrono::system_clock::time_point &p_time )
+    -> std::string
+{
+    auto uses = [&p_config]( const Field &p_field )
+    { return (p_config.fields >> p_field & 1) != 0; };
+
+    std::string time;
+    if (uses(FIELD_TIME))
+        time = format_time(p_config.time_format,
+                           p_time == std::chrono::system_clock::time_point {}
+                           ? now(p_config) : p_time);
+
+    std::string_view function { p_function };
+    function = function.substr(function.find_first_of(' ') + 1);
+    function = function.substr(0, function.find('('));
+
+    std::string_view log_level { p_config.coloured
+                                 ? m_LOG_LABELS[p_level].first
+                                 : m_LOG_LABELS[p_level].second };
+
+    std::string_view name { thread_name };
+
+    uint64_t tid    { uses(FIELD_THREAD_ID) ? thread_id()   : 0 };
+    int64_t  pid    { uses(FIELD_PID)       ? process_id()  : 0 };
+    int32_t  cpu    { uses(FIELD_CPU)       ? current_cpu() : -1 };
+    double   uptime { 0 };
+    if (uses(FIELD_UPTIME))
+        uptime = std::chrono::duration<double>(
+                 std::chrono::steady_clock::now() - backend().start).count();
+
+    std::string_view log_format { p_config.log_format };
+    if (p_config.log_format.empty())
+        log_format = p_config.coloured ? m_LOG_FORMATS.first
+                                       : m_LOG_FORMATS.second;
+    return format(log_format, time, log_level, function, p_file, p_line,
+                  p_msg, p_sequence, tid, name, pid, uptime, cpu);
+}
+
+
+void
+Logger::handle_error( const Config &p_config, std::string_view p_msg )
+{
+    const ErrorPolicy &policy { p_config.error_policy };
+    uint64_t errors { backend().errors.fetch_add(1) + 1 };
+
+    if (policy.callback && !policy.callback(p_msg)) abort_flushed();
+    if (policy.abort_after != 0 && errors >= policy.abort_after)
+        abort_flushed();
+
+    if (!p_config.abort_on_err) return;
+    if (!p_config.ask_continue || !is_stdin_available()) abort_flushed();
+
+    prompt_continue();
+}
+
+
+void
+Logger::abort_flushed( void )
+{
+    Backend::shutdown_all(std::chrono::steady_clock::now() + drain_timeout);
+    std::abort();
+}
+
+
+namespace
+{
+    /** @brief State of the prompt thread. Never freed, like the thread. */
+    struct Prompter
+    {
+        std::mutex              lock;
+        std::condition_variable wake;
+        uint64_t                pending { 0 }; /* errors not yet asked about */
+    };
+
+    /* Set by the first prompt, for fork() to find. */
+    std::atomic<Prompter *> prompter { nullptr };
+}
+
+
+void
+Logger::prompt_continue( void )
+{
+    static Prompter &state { []() -> Prompter &
+    {
+        prompter.store(new Prompter);
+        std::thread { run_prompter }.detach();
+        return *prompter.load();
+    }() };
+
+    std::scoped_lock lock { state.lock };
+    state.pending++;
+    state.wake.notify_one();
+}
+
+
+void
+Logger::run_prompter( void )
+{
+    Prompter        &state { *prompter.load() };
+    std::unique_lock lock  { state.lock };
+
+    while (true) {
+        state.wake.wait(lock, [&state]{ return state.pending != 0; });
+
+        uint64_t errors { std::exchange(state.pending, 0) };
+        lock.unlock();
+        if (!ask_continue(errors)) abort_flushed();
+        lock.lock();
+    }
+}
+
+
+auto
+Logger::ask_continue( const uint64_t &p_errors ) -> bool
+{
+    if (!is_stdin_available()) return false;
+    std::string line;
+
+    while (true) {
+        if (p_errors == 1)
+            std::cerr << "An error has occured, do you want to continue? "
+                         "[y/N] ";
+        else
+            std::cerr << std::format("{} errors have occured, do you want "
+                                     "to continue? [y/N] ", p_errors);
+        std::getline(std::cin, line);
+
+        if (line.empty()) return false;
+
+        char answ { static_cast<char>(std::tolower(line.at(0))) };
+        if (answ == 'y') return true;
+        if (answ == 'n') return false;
+
+        std::cerr << "Please enter y or n.\n";
+    }
+}
+
+
+std::array<Logger::CallSite, Logger::m_CALL_SITE_CAPACITY>
+    Logger::s_call_sites;
+Logger::CallSite Logger::s_overflow_site;
+
+
+auto
+Logger::call_site_key( const char     *p_file,
+                       const uint32_t &p_line,
+                       const uint32_t &p_column ) -> uint64_t
+{
+    uint64_t key { reinterpret_cast<uintptr_t>(p_file) };
+    key ^= (static_cast<uint64_t>(p_line) << 32) ^ p_column;
+    key *= 0x9e3779b97f4a7c15ULL;
+    return key == 0 ? 1 : key;
+}
+
+
+namespace
+{
+    auto
+    trim_function( std::string_view p_function ) -> std::string_view
+    {
+        p_function.remove_prefix(p_function.find_first_of(' ') + 1);
+        return p_function.substr(0, p_function.find('('));
+    }
+
+
+    /** @brief Matches @p p_text against a glob of '*' and '?' wildcards. */
+    auto
+    glob_match( std::string_view p_glob, std::string_view p_text ) -> bool
+    {
+        std::size_t glob { 0 }, text { 0 };
+        std::size_t star { std::string_view::npos }, resume { 0 };
+
+        while (text < p_text.size()) {
+            if (glob < p_glob.size()
+             && (p_glob[glob] == '?' || p_glob[glob] == p_text[text])) {
+                glob++;
+                text++;
+            } else if (glob < p_glob.size() && p_glob[glob] == '*') {
+                star   = glob++;
+                resume = text;
+            } else if (star != std::string_view::npos) {
+                glob = star + 1;
+                text = ++resume;
+            } else {
+                return false;
+            }
+        }
+
+        while (glob < p_glob.size() && p_glob[glob] == '*') glob++;
+        return glob == p_glob.size();
+    }
+
+
+    auto
+    filter_matches( const Logger::CallSiteFilter &p_filter,
+                    std::string_view p_file, std::string_view p_function,
+                    uint32_t p_line, LogLevel p_level ) -> bool
+    {
+        std::string_view name {
+            p_file.substr(p_file.find_last_of("/\\") + 1) };
+
+        if (!p_filter.file.empty() && !glob_match(p_filter.file, p_file)
+         && !glob_match(p_filter.file, name))
+            return false;
+        if (!p_filter.function.empty()
+         && p_filter.function != trim_function(p_function))
+            return false;
+        if (p_filter.line != 0 && p_filter.line != p_line) return false;
+        return !p_filter.level || *p_filter.level == p_level;
+    }
+
+}
+
+
+auto
+Logger::find_call_site( const std::source_location &p_source,
+                        const LogLevel             &p_level ) -> CallSite &
+{
+    uint64_t    key   { call_site_key(p_source.file_name(), p_source.line(),
+                                        p_source.column()) };
+    std::size_t index { call_site_slot(key) };
+
+    for (std::size_t probe { 0 }; probe < m_CALL_SITE_CAPACITY; probe++) {
+        CallSite &site {
+            s_call_sites[(index + probe) % m_CALL_SITE_CAPACITY] };
+        uint64_t  seen { site.key.load(std::memory_order_acquire) };
+
+        if (seen == 0) {
+            /* Claimed under the lock, so that neither set_call_sites() nor
+               a fork() sees the site half registered. */
+            std::scoped_lock lock { site_filter_lock };
+
+            if (site.key.compare_exchange_strong(seen, key,
+                                                 std::memory_order_acq_rel)) {
+                site.file     = p_source.file_name();
+                site.function = p_source.function_name();
+                site.line     = p_source.line();
+                site.column   = p_source.column();
+                site.level    = p_level;
+                apply_call_site_filters(site);
+                return site;
+            }
+        }
+        if (seen != key) continue;
+
+        /* Claimed by another thread that may still be filling it in. */
+        while (!site.ready.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        if (site.line == p_source.line() && site.column == p_source.column()
+         && site.file == p_source.file_name())
+            return site;
+    }
+
+    return s_overflow_site;
+}
+
+
+void
+Logger::apply_call_site_filters( CallSite &p_site )
+{
+    for (const auto &[filter, enabled] : site_filters)
+        if (filter_matches(filter, p_site.file, p_site.function, p_site.line,
+                           p_site.level))
+            p_site.enabled.store(enabled ? 1 : -1, std::memory_order_relaxed);
+
+    p_site.ready.store(true, std::memory_order_release);
+}
+
+
+auto
+Logger::set_call_sites( const CallSiteFilter &p_filter,
+                        const bool           &p_enabled ) -> std::size_t
+{
+    std::scoped_lock lock { site_filter_lock };
+    site_filters.emplace_back(p_filter, p_enabled);
+
+    std::size_t matched { 0 };
+    for (CallSite &site : s_call_sites) {
+        if (!site.ready.load(std::memory_order_acquire)) continue;
+        if (!filter_matches(p_filter, site.file, site.function, site.line,
+                            site.level))
+            continue;
+
+        site.enabled.store(p_enabled ? 1 : -1, std::memory_order_relaxed);
+        matched++;
+    }
+
+    s_forced_sites.store(static_cast<uint64_t>(std::ranges::count_if(
+        site_filters, []( const auto &p_entry ) { return p_entry.second; })));
+    return matched;
+}
+
+
+void
+Logger::reset_call_sites( void )
+{
+    std::scoped_lock lock { site_filter_lock };
+    site_filters.clear();
+
+    for (CallSite &site : s_call_sites)
+        site.enabled.store(0, std::memory_order_relaxed);
+    s_forced_sites.store(0);
+}
+
+
+auto
+Logger::call_site_report( const std::size_t &p_count )
+    -> std::vector<CallSiteStats>
+{
+    std::vector<CallSiteStats> report;
+
+    auto add = [&report]( const CallSite &p_site, std::string_view p_file )
+    {
+        uint64_t hits { p_site.hits.load(std::memory_order_relaxed) };
+        if (hits == 0) return;
+
+        report.push_back({
+            p_file,
+            p_site.function == nullptr ? "" : trim_function(p_site.function),
+            p_site.line, p_site.level, hits,
+            p_site.bytes.load(std::memory_order_relaxed)
+        });
+    };
+
+    for (const CallSite &site : s_call_sites)
+        if (site.ready.load(std::memory_order_acquire)) add(site, site.file);
+    add(s_overflow_site, "<other call sites>");
+
+    std::ranges::sort(report, []( const auto &p_a, const auto &p_b )
+    {
+        if (p_a.bytes != p_b.bytes) return p_a.bytes > p_b.bytes;
+        return p_a.hits > p_b.hits;
+    });
+
+    if (report.size() > p_count) report.resize(p_count);
+    return report;
+}
+
+
+void
+Logger::set_rate_limit( const double                    &p_per_second,
+                        const uint32_t                  &p_burst,
+                        const std::chrono::milliseconds &p_summary )
+{
+    using std::chrono::nanoseconds;
+
+    uint64_t interval { p_per_second > 0
+                        ? static_cast<uint64_t>(1e9 / p_per_second) : 0 };
+
+    s_rate_tolerance_ns.store(interval * (std::max(p_burst, 1U) - 1));
+    s_rate_summary_ns.store(static_cast<uint64_t>(
+        std::chrono::duration_cast<nanoseconds>(p_summary).count()));
+    s_rate_interval_ns.store(interval);
+
+    if (interval != 0) start_housekeeping();
+}
+
+
+auto
+Logger::admit( CallSite &p_site ) -> bool
+{
+    using std::chrono::steady_clock;
+
+    auto now { static_cast<uint64_t>(std::chrono::duration_cast<
+               std::chrono::nanoseconds>(steady_clock::now()
+               .time_since_epoch()).count()) };
+    uint64_t interval  { s_rate_interval_ns.load(std::memory_order_relaxed) };
+    uint64_t tolerance { s_rate_tolerance_ns.load(std::memory_order_relaxed) };
+
+    /* GCRA: one CAS on the theoretical arrival time replaces the bucket. */
+    bool     admitted { true };
+    uint64_t next     { p_site.next_ns.load(std::memory_order_relaxed) };
+    while (true) {
+        uint64_t base { std::max(next, now) };
+        if (base - now > tolerance) {
+            admitted = false;
+            break;
+        }
+        if (p_site.next_ns.compare_exchange_weak(next, base + interval,
+                                                 std::memory_order_relaxed))
+            break;
+    }
+
+    if (!admitted) {
+        std::size_t index { &p_site == &s_overflow_site
+                            ? m_CALL_SITE_CAPACITY
+                            : static_cast<std::size_t>(
+                                  &p_site - s_call_sites.data()) };
+        backend().suppressed_counts()[index]
+            .fetch_add(1, std::memory_order_relaxed);
+        bump(get_counters().limited);
+    }
+
+    return admitted;
+}
+
+
+void
+Logger::report_suppressed( void )
+{
+    std::atomic<uint64_t> *counts { backend().suppressed.load() };
+    if (counts == nullptr) return;
+
+    ConfigPin     pin    { pin_config() };
+    const Config &config { *pin };
+
+    for (std::size_t i { 0 }; i <= m_CALL_SITE_CAPACITY; i++) {
+        if (counts[i].load(std::memory_order_relaxed) == 0) continue;
+        uint64_t count { counts[i].exchange(0) };
+
+        bool            other { i == m_CALL_SITE_CAPACITY };
+        const CallSite &site  { other ? s_overflow_site : s_call_sites[i] };
+        if (!other && !site.ready.load(std::memory_order_acquire)) continue;
+
+        uint64_t sequence { next_sequence(config) };
+        auto     time     { record_time(config) };
+        print_log(compose(config, WARN,
+                          other ? "<other call sites>" : site.file,
+                          other ? "" : site.function, site.line,
+                          std::format("suppressed {} records over the rate "
+                                      "limit of this call site", count),
+                          sequence, time),
+                  true, sequence, time);
+    }
+}
+
+
+void
+Logger::housekeep( const bool &p_final )
+{
+    using std::chrono::steady_clock;
+
+    auto now { static_cast<uint64_t>(std::chrono::duration_cast<
+               std::chrono::nanoseconds>(steady_clock::now()
+               .time_since_epoch()).count()) };
+
+    uint64_t summary { s_next_summary_ns.load(std::memory_order_relaxed) };
+    bool     due     { p_final || (now >= summary && s_next_summary_ns
+        .compare_exchange_strong(summary, now + s_rate_summary_ns.load(
+                                          std::memory_order_relaxed))) };
+
+    /* A backend whose last handle is going away reports for itself. */
+    std::vector<Logger> loggers;
+    {
+        std::scoped_lock lock { Backend::live_lock };
+
+        for (Backend *backend : Backend::live()) {
+            uint32_t refs { backend->refs.load() };
+            while (refs != 0
+                && !backend->refs.compare_exchange_weak(refs, refs + 1)) {}
+            if (refs != 0) loggers.push_back(Logger { backend });
+        }
+    }
+
+    for (Logger &logger : loggers) {
+        if (due) logger.report_suppressed();
+
+        if (p_final) logger.flush_repeats();
+        else         logger.expire_repeats();
+    }
+}
+
+
+void
+Logger::start_housekeeping( void )
+{
+    static std::once_flag at_exit;
+    std::call_once(at_exit, []{ std::atexit(stop_housekeeping); });
+
+    std::scoped_lock lock { housekeeper.lock };
+    if (housekeeper.thread.joinable()) return;
+
+    housekeeper.stopping = false;
+    housekeeper.thread   = std::thread { run_housekeeping };
+}
+
+
+void
+Logger::run_housekeeping( void )
+{
+    std::unique_lock lock { housekeeper.lock };
+
+    while (!housekeeper.wake.wait_for(lock, housekeeping_tick,
+                                      []{ return housekeeper.stopping; })) {
+        lock.unlock();
+        housekeep(false);
+        lock.lock();
+    }
+}
+
+
+void
+Logger::stop_housekeeping( void )
+{
+    {
+        std::scoped_lock lock { housekeeper.lock };
+        if (!housekeeper.thread.joinable()) return;
+
+        housekeeper.stopping = true;
+        housekeeper.wake.notify_one();
+    }
+
+    housekeeper.thread.join();
+}
+
+
+auto
+Logger::sample( const SamplePolicy &p_policy,
+                const LogLevel     &p_level ) -> bool
+{
+    thread_local std::array<uint32_t, __LOG_LEVEL_AMOUNT> seen {};
+
+    if (p_policy.every > 1 && ++seen[p_level] % p_policy.every != 0)
+        return false;
+
+    uint64_t threshold { p_policy.threshold };
+
+    if (p_policy.budget != 0) {
+        Backend::SampleWindow &window { backend().sample_windows[p_level] };
+
+        auto second { static_cast<uint64_t>(std::chrono::duration_cast<
+                      std::chrono::seconds>(std::chrono::steady_clock::now()
+                      .time_since_epoch()).count()) };
+        uint64_t last { window.second.load(std::memory_order_relaxed) };
+
+        /* Last second's load predicts this one, the running count catches
+           a burst before the second is over. */
+        if (second != last && window.second.compare_exchange_strong(
+                                  last, second, std::memory_order_relaxed)) {
+            uint64_t offered { window.count.exchange(0) };
+            window.scale.store(offered <= p_policy.budget
+                               ? 1ULL << 32
+                               : (p_policy.budget << 32) / offered,
+                               std::memory_order_relaxed);
+        }
+
+        uint64_t count { window.count.fetch_add(1, std::memory_order_relaxed)
+                         + 1 };
+        uint64_t scale { window.scale.load(std::memory_order_relaxed) };
+        if (count > p_policy.budget)
+            scale = std::min(scale, (p_policy.budget << 32) / count);
+
+        threshold = (threshold >> 16) * (scale >> 16);
+    }
+
+    return random32() < threshold;
+}
+
+
+auto
+Logger::is_repeat( const Config     &p_config,
+                   const LogLevel   &p_level,
+                   CallSite         &p_site,
+                   std::string_view  p_msg ) -> bool
+{
+    using std::chrono::steady_clock;
+
+    uint64_t hash { std::hash<std::string_view> {}(p_msg) };
+    hash ^= reinterpret_cast<uintptr_t>(&p_site) * 0x9e3779b97f4a7c15ULL;
+    hash += p_level;
+
+    Repeats &last { backend().repeats[
+                    backend().to_file.load() ? 0 : p_level >= WARN] };
+    std::scoped_lock lock { last.lock };
+
+    if (hash == last.hash && last.site == &p_site && last.level == p_level
+     && last.msg == p_msg) {
+        steady_clock::time_point now { steady_clock::now() };
+        if (last.count++ == 0) last.since = now;
+        bump(get_counters().collapsed);
+
+        if (now - last.since >= p_config.repeat_timeout)
+            report_repeats(p_config, last);
+        return true;
+    }
+
+    report_repeats(p_config, last);
+
+    last.hash  = hash;
+    last.count = 0;
+    last.site  = &p_site;
+    last.level = p_level;
+    last.msg.assign(p_msg);
+    return false;
+}
+
+
+void
+Logger::flush_repeats( void )
+{
+    ConfigPin     pin    { pin_config() };
+    const Config &config { *pin };
+
+    for (Repeats &last : backend().repeats) {
+        std::scoped_lock lock { last.lock };
+        report_repeats(config, last);
+    }
+}
+
+
+void
+Logger::expire_repeats( void )
+{
+    ConfigPin     pin    { pin_config() };
+    const Config &config { *pin };
+    auto          now    { std::chrono::steady_clock::now() };
+
+    for (Repeats &last : backend().repeats) {
+        std::scoped_lock lock { last.lock };
+        if (last.count != 0 && now - last.since >= config.repeat_timeout)
+            report_repeats(config, last);
+    }
+}
+
+
+void
+Logger::report_repeats( const Config &p_config, Repeats &p_last )
+{
+    if (p_last.count == 0) return;
+
+    uint64_t sequence { next_sequence(p_config) };
+    auto     time     { record_time(p_config) };
+    print_log(compose(p_config, p_last.level, p_last.site->file,
+                      p_last.site->function, p_last.site->line,
+                      std::format("last message repeated {} times",
+                                  p_last.count),
+                      sequence, time),
+              p_last.level >= WARN, sequence, time);
+    p_last.count = 0;
+}
+
+
+Logger::RequestScope::RequestScope( const std::chrono::milliseconds &p_budget,
+                                    const LogLevel    &p_level,
+                                    const std::size_t &p_capacity ) :
+    m_parent(s_current),
+    m_level(p_level),
+    m_capacity(std::max<std::size_t>(p_capacity, 1)),
+    m_failed(false),
+    m_budget(p_budget),
+    m_start(std::chrono::steady_clock::now())
+{ s_current = this; }
+
+
+Logger::RequestScope::Deferred::~Deferred( void )
+{
+    if (destroy != nullptr) destroy(*this);
+
+    Logger release { shared }; /* drops the record's reference */
+}
+
+
+auto
+Logger::RequestScope::Deferred::logger( void ) const -> Logger
+{
+    shared->refs.fetch_add(1, std::memory_order_relaxed);
+
+    Logger handle { shared };
+    handle.m_level = node;
+    return handle;
+}
+
+
+Logger::RequestScope::~RequestScope( void )
+{
+    s_current = m_parent;
+
+    if (m_budget.count() > 0
+     && std::chrono::steady_clock::now() - m_start > m_budget)
+        fail();
+}
+
+
+void
+Logger::RequestScope::fail( void )
+{
+    m_failed = true;
+
+    for (Deferred &record : m_records) {
+        Logger    logger { record.logger() };
+        CallSite &site   { find_call_site(record.source, record.level) };
+
+        ConfigPin   pin      { logger.pin_config() };
+        uint64_t    sequence { next_sequence(*pin) };
+        std::string full { logger.compose(
+            *pin, record.level, record.source.file_name(),
+            record.source.function_name(), record.source.line(),
+            record.message(), sequence, record.time) };
+
+        bump(logger.get_counters().records[record.level]);
+        site.hits.fetch_add(1, std::memory_order_relaxed);
+        site.bytes.fetch_add(full.size(), std::memory_order_relaxed);
+        logger.print_log(std::move(full), false, sequence, record.time);
+    }
+
+    m_records.clear();
+}
+
+
+namespace
+{
+    std::atomic<std::size_t> exit_report_count { 0 };
+
+
+    auto
+    format_call_site_report( const std::size_t &p_count ) -> std::string
+    {
+        std::vector<Logger::CallSiteStats> report {
+            Logger::call_site_report(p_count) };
+
+        std::string text { std::format("Top {} call sites by volume:\n",
+                                       report.size()) };
+        for (const Logger::CallSiteStats &site : report)
+            text += std::format("{:>12} bytes {:>10} hits  {}:{} {}\n",
+                                site.bytes, site.hits, site.file, site.line,
+                                site.function);
+        return text;
+    }
+
+
+    void
+    print_call_site_report( void )
+    { std::cerr << format_call_site_report(exit_report_count.load()); }
+}
+
+
+void
+Logger::report_call_sites_at_exit( const std::size_t &p_count )
+{
+    if (exit_report_count.exchange(p_count) == 0)
+        std::atexit(print_call_site_report);
+}
+
+
+#ifndef _WIN32
+namespace
+{
+    auto
+    parse_level( std::string_view p_name ) -> std::optional<LogLevel>
+    {
+        constexpr std::array<std::string_view, __LOG_LEVEL_AMOUNT> names {
+            "debug", "info", "warn", "error"
+        };
+
+        for (std::size_t i { 0 }; i < names.size(); i++)
+            if (p_name == names[i]) return static_cast<LogLevel>(i);
+        return std::nullopt;
+    }
+
+
+    auto
+    split_words( std::string_view p_line ) -> std::vector<std::string_view>
+    {
+        constexpr std::string_view blanks { " \t\r" };
+        std::vector<std::string_view> words;
+
+        while (true) {
+            std::size_t start { p_line.find_first_not_of(blanks) };
+            if (start == std::string_view::npos) break;
+            p_line.remove_prefix(start);
+
+            std::size_t end { std::min(p_line.find_first_of(blanks),
+                                       p_line.size()) };
+            words.push_back(p_line.substr(0, end));
+            p_line.remove_prefix(end);
+        }
+
+        return words;
+    }
+
+
+    /** @brief Parses the key=value fields of an enable/disable command. */
+    auto
+    parse_filter( const std::vector<std::string_view> &p_words,
+                  Logger::CallSiteFilter             &p_filter )
+        -> std::optional<std::string>
+    {
+        for (std::size_t i { 1 }; i < p_words.size(); i++) {
+            std::size_t      equals { p_words[i].find('=') };
+            std::string_view key    { p_words[i].substr(0, equals) };
+            std::string_view value;
+            if (equals != std::string_view::npos)
+                value = p_words[i].substr(equals + 1);
+
+            if (key == "file") {
+                p_filter.file = value;
+            } else if (key == "function") {
+                p_filter.function = value;
+            } else if (key == "line") {
+                auto [end, error] { std::from_chars(
+                    value.data(), value.data() + value.size(),
+                    p_filter.line) };
+                if (error != std::errc {}
+                 || end != value.data() + value.size())
+                    return std::format("invalid line {}", value);
+            } else if (key == "level") {
+                p_filter.level = parse_level(value);
+                if (!p_filter.level)
+                    return std::format("unknown level {}", value);
+            } else {
+                return std::format("unknown field {}", key);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+
+    /** @brief Runs one line of the control protocol, returns the reply. */
+    auto
+    run_control_command( Logger &p_logger, std::string_view p_line )
+        -> std::string
+    {
+        std::vector<std::string_view> words { split_words(p_line) };
+        if (words.empty()) return "";
+
+        std::string_view command { words[0] };
+
+        if (command == "level" && (words.size() == 2 || words.size() == 3)) {
+            std::optional<LogLevel> level { parse_level(words[1]) };
+            if (!level) return std::format("error: unknown level {}\n",
+                                           words[1]);
+
+            Logger::set_level(std::string { words.size() == 3 ? words[2]
+                                                              : "" },
+                              *level);
+            return "ok\n";
+        }
+
+        if (command == "reset" && words.size() == 2) {
+            Logger::reset_level(std::string { words[1] });
+            return "ok\n";
+        }
+
+        if (command == "enable" || command == "disable") {
+            Logger::CallSiteFilter filter;
+            if (auto error { parse_filter(words, filter) })
+                return std::format("error: {}\n", *error);
+
+            return std::format("ok, {} call sites matched\n",
+                               Logger::set_call_sites(filter,
+                                                      command == "enable"));
+        }
+
+        if (command == "reset-sites" && words.size() == 1) {
+            Logger::reset_call_sites();
+            return "ok\n";
+        }
+
+        if (command == "flush" && words.size() == 1) {
+            p_logger.flush();
+            return "ok\n";
+        }
+
+        if (command == "dump" && words.size() == 2) {
+            try {
+                p_logger.snapshot(std::string { words[1] });
+            } catch (const std::exception &e) {
+                return std::format("error: {}\n", e.what());
+            }
+            return "ok\n";
+        }
+
+        if (command == "stats" && words.size() == 1) {
+            Logger::Stats stats { p_logger.stats() };
+            return std::format(
+                "records   debug={} info={} warn={} error={}\n"
+                "filtered  {}\nbytes     {}\ndropped   {}\ntruncated {}\n"
+                "limited   {}\ncollapsed {}\nsampled   {}\n"
+                "print_ns  {}\n",
+                stats.records[DEBUG], stats.records[INFO],
+                stats.records[WARN], stats.records[ERROR], stats.filtered,
+                stats.bytes, stats.dropped, stats.truncated, stats.limited,
+                stats.collapsed, stats.sampled, stats.print_time.count());
+        }
+
+        if (command == "report" && words.size() <= 2) {
+            std::size_t count { 10 };
+            if (words.size() == 2) {
+                auto [end, error] { std::from_chars(
+                    words[1].data(), words[1].data() + words[1].size(),
+                    count) };
+                if (error != std::errc {}
+                 || end != words[1].data() + words[1].size())
+                    return std::format("error: invalid count {}\n", words[1]);
+            }
+            return format_call_site_report(count);
+        }
+
+        return std::format("error: invalid command \"{}\", expected level, "
+                           "reset, enable, disable, reset-sites, flush, "
+                           "dump, stats or report\n", p_line);
+    }
+
+
+    #ifndef MSG_NOSIGNAL
+        #define MSG_NOSIGNAL 0
+    #endif
+
+
+    /** @brief The process' control channel, see Logger::serve_control(). */
+    struct Control
+    {
+        std::mutex            lock;
+        std::thread           thread;
+        std::optional<Logger> logger;
+        std::string           path;
+        int                   listener { -1 };
+        std::array<int, 2>    wake     { -1, -1 };
+    };
+    Control control;
+
+
+    /* A client quiet for this long is dropped, so it can not hold the
+       channel from the others. */
+    constexpr int32_t client_timeout_ms { 5000 };
+
+
+    /** @return False once the channel is being closed or @p p_timeout_ms
+     *          pass without input. */
+    auto
+    wait_readable( const int &p_fd, const int32_t &p_timeout_ms = -1 )
+        -> bool
+    {
+        std::array<pollfd, 2> fds {{
+            { p_fd, POLLIN, 0 }, { control.wake[0], POLLIN, 0 }
+        }};
+
+        int ready;
+        while ((ready = poll(fds.data(), fds.size(), p_timeout_ms)) < 0)
+            if (errno != EINTR) return false;
+        return ready > 0 && fds[1].revents == 0;
+    }
+
+
+    auto
+    send_all( const int &p_fd, std::string_view p_data ) -> bool
+    {
+        while (!p_data.empty()) {
+            ssize_t sent { send(p_fd, p_data.data(), p_data.size(),
+                                MSG_NOSIGNAL) };
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent <= 0) return false;
+            p_data.remove_prefix(static_cast<std::size_t>(sent));
+        }
+        return true;
+    }
+
+
+    void
+    serve_client( const int &p_client )
+    {
+        constexpr std::size_t max_line { 4096 };
+
+        std::array<char, 512> buffer;
+        std::string           pending;
+
+        while (wait_readable(p_client, client_timeout_ms)) {
+            ssize_t size { read(p_client, buffer.data(), buffer.size()) };
+            if (size < 0 && errno == EINTR) continue;
+            if (size < 0) return;
+
+            if (size == 0) pending += '\n'; /* answer an unterminated line */
+            pending.append(buffer.data(), static_cast<std::size_t>(size));
+
+            std::size_t end;
+            while ((end = pending.find('\n')) != std::string::npos) {
+                std::string reply { run_control_command(
+                    *control.logger, std::string_view { pending }
+                                     .substr(0, end)) };
+                pending.erase(0, end + 1);
+                if (!send_all(p_client, reply)) return;
+            }
+
+            if (size == 0 || pending.size() > max_line) return;
+        }
+    }
+
+
+    void
+    run_control( void )
+    {
+        while (wait_readable(control.listener)) {
+            int client { accept(control.listener, nullptr, nullptr) };
+            if (client < 0) continue;
+
+            serve_client(client);
+            close(client);
+        }
+    }
+
+
+    /** @brief Stops the channel, the caller holds control.lock. */
+    void
+    close_control( void )
+    {
+        if (!control.thread.joinable()) return;
+
+        /* The read end of the pipe polls as hung up, which wakes the
+           thread wherever it waits. */
+        close(control.wake[1]);
+        control.thread.join();
+
+        close(control.wake[0]);
+        close(control.listener);
+        unlink(control.path.c_str());
+        control.logger.reset();
+    }
+}
+#endif
+
+
+void
+Logger::serve_control( const std::string &p_path )
+{
+#ifdef _WIN32
+    throw std::runtime_error { std::format(
+        "Failed to serve control socket {}: Unix domain sockets are not "
+        "supported", p_path) };
+#else
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if (p_path.empty() || p_path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error { std::format(
+            "Failed to serve control socket {}: invalid path", p_path) };
+    std::memcpy(address.sun_path, p_path.data(), p_path.size());
+
+    static std::once_flag at_exit;
+    std::call_once(at_exit, []{ std::atexit(stop_control); });
+
+    std::scoped_lock lock { control.lock };
+    close_control();
+
+    unlink(p_path.c_str());
+    int listener { socket(AF_UNIX, SOCK_STREAM, 0) };
+
+    if (listener < 0
+     || bind(listener, reinterpret_cast<const sockaddr *>(&address),
+             sizeof(address)) != 0
+     || listen(listener, 4) != 0 || pipe(control.wake.data()) != 0) {
+        int error { errno };
+        if (listener >= 0) close(listener);
+
+        throw std::runtime_error { std::format(
+            "Failed to serve control socket {}: {}", p_path,
+            std::strerror(error)) };
+    }
+
+    control.listener = listener;
+    control.path     = p_path;
+    control.logger.emplace(*this);
+    control.thread   = std::thread { run_control };
+#endif
+}
+
+
+void
+Logger::stop_control( void )
+{
+#ifndef _WIN32
+    std::scoped_lock lock { control.lock };
+    close_control();
+#endif
+}
+
+
+#ifndef _WIN32
+namespace
+{
+    /* What before_fork() locked, as a prompt or snapshot may start after. */
+    struct Forking
+    {
+        Prompter        *prompter;
+        SignalSnapshots *snapshots;
+    };
+    Forking forking;
+}
+
+
+void
+Logger::before_fork( void )
+{
+    /* Control first, stop_control() waits for its thread under the lock
+       while the thread may be taking any of the others. */
+    control.lock.lock();
+    housekeeper.lock.lock();
+
+    forking = { prompter.load(), snapshots.load() };
+    if (forking.prompter != nullptr)  forking.prompter->lock.lock();
+    if (forking.snapshots != nullptr) forking.snapshots->lock.lock();
+
+    registry_lock.lock();
+    site_filter_lock.lock();
+    Backend::lock_all();
+}
+
+
+void
+Logger::after_fork_parent( void )
+{
+    Backend::unlock_all();
+    site_filter_lock.unlock();
+    registry_lock.unlock();
+
+    if (forking.snapshots != nullptr) forking.snapshots->lock.unlock();
+    if (forking.prompter != nullptr)  forking.prompter->lock.unlock();
+
+    housekeeper.lock.unlock();
+    control.lock.unlock();
+}
+
+
+/**
+ * @brief Resets what the child did not inherit: every thread but the one
+ *        calling fork(), and the control socket, which is the parent's to
+ *        serve and remove. Condition variables a thread of the parent may
+ *        have waited on are written over, as they can not be destroyed.
+ */
+void
+Logger::after_fork_child( void )
+{
+    forks.fetch_add(1, std::memory_order_relaxed);
+
+    Backend::reset_all();
+    site_filter_lock.unlock();
+    registry_lock.unlock();
+
+    /* A pipe of its own, or signals to the child would wake the parent. */
+    if (SignalSnapshots *state { forking.snapshots }) {
+        signal_pipe = -1;
+        close(state->pipe[0]);
+        close(state->pipe[1]);
+
+        if (pipe(state->pipe.data()) == 0) {
+            fcntl(state->pipe[1], F_SETFL, O_NONBLOCK);
+            signal_pipe = state->pipe[1];
+            std::thread { run_signal_snapshots, std::ref(*state) }.detach();
+        }
+        state->lock.unlock();
+    }
+
+    /* The parent asks about the errors it counted. */
+    if (Prompter *state { forking.prompter }) {
+        state->pending = 0;
+        new (&state->wake) std::condition_variable;
+        std::thread { run_prompter }.detach();
+        state->lock.unlock();
+    }
+
+    if (housekeeper.thread.joinable()) {
+        new (&housekeeper.wake)   std::condition_variable;
+        new (&housekeeper.thread) std::thread { run_housekeeping };
+    }
+    housekeeper.lock.unlock();
+
+    if (control.thread.joinable()) {
+        close(control.listener);
+        close(control.wake[0]);
+        close(control.wake[1]);
+
+        new (&control.thread) std::thread;
+        control.listener = -1;
+        control.wake     = { -1, -1 };
+        control.path.clear();
+        control.logger.reset();
+    }
+    control.lock.unlock();
+}
+#endif
+
+
+void
+Logger::print_log( std::string     p_msg,
+                   const bool     &p_err,
+                   const uint64_t &p_sequence,
+                   const std::chrono::system_clock::time_point &p_time )
+{
+    using std::chrono::steady_clock;
+
+    if (backend().backtrace_capacity.load(std::memory_order_relaxed) != 0)
+        backend().remember(p_msg);
+
+    Counters &counters { get_counters() };
+    std::size_t bytes { p_msg.size() };
+    steady_clock::time_point start { steady_clock::now() };
+
+    int64_t time { std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   p_time.time_since_epoch()).count() };
+    if (backend().submit(std::move(p_msg), p_err, p_sequence, time))
+        bump(counters.bytes, bytes);
+    else
+        bump(counters.dropped);
+
+    bump(counters.print_ns, static_cast<uint64_t>(
+         std::chrono::duration_cast<std::chrono::nanoseconds>(
+         steady_clock::now() - start).count()));
+}
\ No newline at end of file
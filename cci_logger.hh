@@ -1,8 +1,22 @@
 #pragma once
 #include <source_location>
 #include <string_view>
+#include <functional>
+#include <optional>
+#include <memory>
+#include <type_traits>
 #include <cstdint>
 #include <format>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <deque>
+#include <array>
+#include <bit>
+#include <new>
+#include <tuple>
+#include <cstddef>
 
 
 /**
@@ -34,6 +48,308 @@ public:
     };
 
 
+    /**
+     * @brief Where record timestamps are read from. Each falls back to
+     *        SYSTEM where it is not available.
+     */
+    enum class Clock : uint8_t
+    {
+        SYSTEM,          /**< std::chrono::system_clock.                  */
+        REALTIME_COARSE, /**< Last tick of the realtime clock, ms grained. */
+        MONOTONIC_RAW,   /**< Hardware clock, calibrated to wall time.     */
+        TSC              /**< CPU time stamp counter, calibrated likewise. */
+    };
+
+
+    /**
+     * @brief Admission policy that keeps only part of a level's records.
+     */
+    struct Sampling
+    {
+        uint32_t every       { 1 };   /**< Keep every Nth record per thread. */
+        double   probability { 1.0 }; /**< Chance of keeping a record.       */
+
+        /**
+         * Records per second above which the probability is lowered in
+         * proportion to the excess, 0 to never adapt.
+         */
+        uint64_t budget { 0 };
+    };
+
+
+    /**
+     * @brief What ERROR records do besides being printed, checked in order
+     *        before abort_on_error().
+     */
+    struct ErrorPolicy
+    {
+        /**
+         * Called on the logging thread with the formatted message, returns
+         * false to abort.
+         */
+        std::function<bool( std::string_view )> callback {};
+
+        uint64_t abort_after { 0 }; /**< ERROR records that abort, 0 never. */
+    };
+
+
+    /**
+     * @brief Aggregated self-instrumentation counters of a Logger.
+     */
+    struct Stats
+    {
+        /** Printed per level, not counting any of the drops below. */
+        std::array<uint64_t, __LOG_LEVEL_AMOUNT> records {};
+
+        uint64_t filtered  { 0 }; /**< Below the threshold level.       */
+        uint64_t bytes     { 0 }; /**< Handed to the output.            */
+        uint64_t dropped   { 0 }; /**< Lost to a full async queue.      */
+        uint64_t truncated { 0 }; /**< Cut short by log_signal_safe().  */
+        uint64_t limited   { 0 }; /**< Over their call site rate limit. */
+        uint64_t collapsed { 0 }; /**< Repeats of the previous record.  */
+        uint64_t sampled   { 0 }; /**< Left out by level sampling.      */
+
+        std::chrono::nanoseconds print_time { 0 };
+    };
+
+
+    /**
+     * @brief Volume logged by a single log<> call site, across all Loggers.
+     */
+    struct CallSiteStats
+    {
+        std::string_view file;
+        std::string_view function;
+        uint32_t         line;
+        LogLevel         level;
+
+        uint64_t hits;
+        uint64_t bytes;
+    };
+
+
+    /**
+     * @brief Selects log<> call sites to switch on or off at runtime. Empty
+     *        fields match every site.
+     */
+    struct CallSiteFilter
+    {
+        std::string file     {}; /**< Glob on the path or file name.    */
+        std::string function {}; /**< Function, like "main" or "A::f".  */
+        uint32_t    line     { 0 };
+
+        std::optional<LogLevel> level {};
+    };
+
+
+private:
+    struct Shared;
+    struct LevelNode;
+
+public:
+    /**
+     * @brief Buffers the DEBUG and INFO records of one request, on the thread
+     *        that creates it, and only prints them if the request goes bad.
+     *
+     * While a scope is alive, low level records of any Logger are kept in
+     * deferred form: the format string and a copy of the arguments, not yet
+     * formatted. They are printed, even below the Logger's threshold, as
+     * soon as an ERROR is logged or fail() is called, or when the scope
+     * ends after its latency budget. Otherwise they are discarded unread.
+     *
+     * Each record keeps a handle on its Logger, so temporaries like
+     * Logger::get() may be logged through. Scopes nest; only the innermost
+     * one buffers.
+     */
+    class RequestScope
+    {
+    public:
+        /**
+         * @param p_budget   Latency above which the request counts as
+         *                   failed, 0 to only fail on errors.
+         * @param p_level    Lowest level buffered (default DEBUG).
+         * @param p_capacity Records kept, the oldest are dropped first.
+         */
+        explicit RequestScope( const std::chrono::milliseconds &p_budget =
+                                     std::chrono::milliseconds(0),
+                               const LogLevel    &p_level    = DEBUG,
+                               const std::size_t &p_capacity = 1024 );
+        ~RequestScope( void );
+
+        RequestScope( const RequestScope & ) = delete;
+        auto operator=( const RequestScope & ) -> RequestScope & = delete;
+
+
+        /**
+         * @brief Prints the buffered records, and lets every further record
+         *        of this scope through unbuffered.
+         */
+        void fail( void );
+
+    private:
+        friend class Logger;
+
+        /**
+         * @brief A record not yet formatted. Its format string and arguments
+         *        are kept inline, so it is built in place and never moved.
+         */
+        struct Deferred
+        {
+            Shared                               *shared; /* holds a ref */
+            LevelNode                            *node;
+            LogLevel                              level;
+            std::source_location                  source;
+            std::chrono::system_clock::time_point time;
+
+            /* A tuple of the format string and arguments, formatted and
+               destroyed through the two functions. If it would not fit,
+               the message is formatted up front instead. */
+            alignas(std::max_align_t) std::array<std::byte, 128> storage;
+            std::string (*format)( const Deferred & );
+            void        (*destroy)( Deferred & );
+            std::string   formatted;
+
+
+            template<typename... T_Args>
+            Deferred( Logger             &p_logger,
+                      const LogLevel     &p_level,
+                      const FormatString &p_fmt,
+                      T_Args         &&...p_args ) :
+                shared(p_logger.m_shared),
+                node(p_logger.m_level),
+                level(p_level),
+                source(p_fmt.source),
+                time(Logger::now(*p_logger.pin_config())),
+                format(nullptr),
+                destroy(nullptr)
+            {
+                shared->refs.fetch_add(1, std::memory_order_relaxed);
+
+                using Kept = std::tuple<std::string, decltype(keep_arg(
+                    std::forward<T_Args>(p_args)))...>;
+
+                if constexpr (sizeof(Kept) <= sizeof(storage)
+                           && alignof(Kept) <= alignof(std::max_align_t)) {
+                    new (storage.data()) Kept {
+                        std::string { p_fmt.fmt },
+                        keep_arg(std::forward<T_Args>(p_args))... };
+
+                    format = []( const Deferred &p_record ) -> std::string
+                    {
+                        return std::apply([]( const std::string &p_format,
+                                              const auto &...p_kept )
+                        { return format_message(p_format, p_kept...); },
+                        *std::launder(reinterpret_cast<const Kept *>(
+                            p_record.storage.data())));
+                    };
+                    destroy = []( Deferred &p_record )
+                    {
+                        std::launder(reinterpret_cast<Kept *>(
+                            p_record.storage.data()))->~Kept();
+                    };
+                } else
+                    formatted = format_message(p_fmt.fmt, p_args...);
+            }
+
+            ~Deferred( void );
+
+            Deferred( const Deferred & ) = delete;
+            auto operator=( const Deferred & ) -> Deferred & = delete;
+
+
+            /** @brief Returns a handle on the Logger the record was for. */
+            auto logger( void ) const -> Logger;
+
+            auto message( void ) const -> std::string
+            { return format != nullptr ? format(*this) : formatted; }
+        };
+
+        static inline thread_local RequestScope *s_current;
+
+        RequestScope *m_parent;
+        LogLevel      m_level;
+        std::size_t   m_capacity;
+        bool          m_failed;
+
+        std::chrono::steady_clock::duration   m_budget;
+        std::chrono::steady_clock::time_point m_start;
+        std::deque<Deferred>                  m_records;
+
+
+        /** @brief Copies views and C strings, so they can not dangle. */
+        template<typename T>
+        static auto
+        keep_arg( T &&p_arg )
+        {
+            using type = std::decay_t<T>;
+            if constexpr (std::is_convertible_v<type, std::string_view>
+                      && !std::is_same_v<type, std::string>
+                      && !std::is_same_v<type, std::nullptr_t>)
+                return std::string { std::string_view { p_arg } };
+            else
+                return type { std::forward<T>(p_arg) };
+        }
+
+
+        template<typename... T_Args>
+        void defer( Logger             &p_logger,
+                    const LogLevel     &p_level,
+                    const FormatString &p_fmt,
+                    T_Args         &&...p_args )
+        {
+            if (m_records.size() >= m_capacity) m_records.pop_front();
+
+            m_records.emplace_back(p_logger, p_level, p_fmt,
+                                   std::forward<T_Args>(p_args)...);
+        }
+    };
+
+
+    /**
+     * @brief Writes out, in timestamp order, the records that every process
+     *        logging under one name put in its shared memory ring.
+     *
+     * Rings of processes that have exited, and rings their process
+     * replaced or closed, are removed once drained.
+     */
+    class Collector
+    {
+    public:
+        /**
+         * @param p_name   Name given to set_shared_memory_output().
+         * @param p_window How long records are held back, so that a record
+         *                 from a ring read later can still be put before
+         *                 them.
+         */
+        explicit Collector( const std::string               &p_name,
+                            const std::chrono::milliseconds &p_window =
+                                  std::chrono::milliseconds(100) );
+        ~Collector( void );
+
+        Collector( const Collector & ) = delete;
+        auto operator=( const Collector & ) -> Collector & = delete;
+
+
+        /**
+         * @brief Maps new rings, drains every ring, and writes the records
+         *        older than the window.
+         * @return The amount of records written.
+         */
+        auto poll( std::FILE *p_output ) -> std::size_t;
+
+
+        /**
+         * @brief Drains every ring, and writes every record left.
+         * @return The amount of records written.
+         */
+        auto finish( std::FILE *p_output ) -> std::size_t;
+
+    private:
+        struct State;
+        State *m_state;
+    };
+
+
     /**
      * @brief Constructs a Logger with optional log level threshold.
      * @param p_loglevel Minimum level to log (default WARN).
@@ -41,16 +357,91 @@ public:
     Logger( const LogLevel &p_loglevel = WARN );
 
 
+    /**
+     * @brief Copies are cheap handles: they share the configuration and
+     *        output of @p p_other through a reference count, and only keep
+     *        their own threshold level.
+     */
+    Logger( const Logger &p_other );
+    auto operator=( const Logger &p_other ) -> Logger &;
+    ~Logger( void );
+
+
+    /**
+     * @brief Sets the minimum level logged through this copy only, which
+     *        also detaches a named Logger from its registry level.
+     * @param p_loglevel Minimum level to log.
+     */
+    void set_level( const LogLevel &p_loglevel );
+
+
+    /**
+     * @brief Returns the registry Logger called @p p_name.
+     * @param p_name Dotted name, like "net.http"; "" is the root.
+     *
+     * Named Loggers are handles on the root Logger: they share its
+     * configuration and output, but take their threshold from the closest
+     * level set on their name or its parents ("net.http", "net", "").
+     */
+    static auto get( const std::string &p_name ) -> Logger;
+
+
+    /**
+     * @brief Sets the level of a registry name and its children that do
+     *        not set their own.
+     * @param p_name     Dotted name, "" is the root (default WARN).
+     * @param p_loglevel Minimum level to log.
+     */
+    static void set_level( const std::string &p_name,
+                           const LogLevel    &p_loglevel );
+
+
+    /**
+     * @brief Makes a registry name inherit its parent's level again.
+     */
+    static void reset_level( const std::string &p_name );
+
+
     /**
      * @brief Sets the time format string for log timestamps.
-     * @param p_fmt Format string (e.g., "%H:%M:%S").
+     * @param p_fmt Format string (e.g., "%H:%M:%S"), with the tokens:
+     *              - %D date, %H hours, %M minutes and %S seconds.
+     *              - %MS, %US and %NS the milli-, micro- and nanoseconds
+     *                of the second.
+     *              - %ISO ISO-8601 with microseconds and UTC offset.
+     *              - %ES, %EMS, %EUS and %ENS time since the epoch in
+     *                seconds, milli-, micro- and nanoseconds.
      */
     void set_time_format( const std::string &p_fmt = "%MS.%S:%M" );
 
 
+    /**
+     * @brief Selects the clock record timestamps are read from.
+     * @param p_clock Clock to use (default SYSTEM).
+     *
+     * MONOTONIC_RAW and TSC are converted to wall time by a multiply-add,
+     * calibrated against the system clock when first selected (a 10 ms
+     * spin) and re-synced every 100 ms. They never step back, but steer
+     * towards the system clock by their rate, so they follow steps of it
+     * gradually. MONOTONIC_RAW is a vDSO call like SYSTEM plus the
+     * conversion, so it buys an unslewed source, not speed; only TSC and
+     * REALTIME_COARSE are cheaper than SYSTEM.
+     */
+    void set_clock( const Clock &p_clock = Clock::SYSTEM );
+
+
     /**
      * @brief Sets the overall log message format.
-     * @param p_fmt Format string with placeholders.
+     * @param p_fmt Format string with placeholders:
+     *              - {0} time, {1} level, {2} function, {3} file, {4} line
+     *                and {5} message.
+     *              - {6} sequence number.
+     *              - {7} thread id and {8} set_thread_name() name.
+     *              - {9} process id.
+     *              - {10} seconds since the Logger was created, a double.
+     *              - {11} CPU the record was composed on, -1 if unknown.
+     *
+     * Only the fields the format references are captured.
      */
     void set_log_format( const std::string &p_fmt );
 
@@ -61,6 +452,28 @@ public:
     void set_log_format( void );
 
 
+    /**
+     * @brief Names the calling thread for the {8} log format field.
+     */
+    static void set_thread_name( const std::string &p_name );
+
+
+    /**
+     * @brief Samples the records of a level, after the threshold check and
+     *        before any formatting.
+     * @param p_level    Level to sample.
+     * @param p_sampling Policy to apply.
+     */
+    void set_sampling( const LogLevel &p_level,
+                       const Sampling &p_sampling );
+
+
+    /**
+     * @brief Resets the sampling, keeping every record of @p p_level.
+     */
+    void set_sampling( const LogLevel &p_level );
+
+
     /**
      * @brief Enables or disables aborting on error log entries.
      * @param p_abort True to abort on errors (default true).
@@ -71,10 +484,29 @@ public:
     /**
      * @brief Enables or disables prompting user to continue on error.
      * @param p_ask True to prompt user (default true).
+     *
+     * The prompt is shown by a single background thread, one at a time for
+     * every Logger, while the thread that logged the error carries on. The
+     * process aborts if the answer is no, and right away if stdin is not a
+     * terminal.
      */
     void ask_continue_on_error( const bool &p_ask = true );
 
 
+    /**
+     * @brief Sets the callback and error count limit for ERROR records.
+     * @param p_policy Policy to apply.
+     */
+    void set_error_policy( const ErrorPolicy &p_policy );
+
+
+    /**
+     * @brief Resets the error policy, leaving ERROR records to
+     *        abort_on_error().
+     */
+    void set_error_policy( void );
+
+
     /**
      * @brief Enables or disables coloured log output.
      * @param p_coloured True to enable colours (default true).
@@ -82,6 +514,285 @@ public:
     void set_coloured_log( const bool &p_coloured = true );
 
 
+    /**
+     * @brief Collapses consecutive identical records into one, followed by a
+     *        "last message repeated N times" record.
+     * @param p_collapse True to collapse repeats (default true).
+     * @param p_timeout  Longest a run of repeats is held back before its
+     *                   count is reported.
+     *
+     * Records are compared per output by level, call site and message,
+     * before the timestamp and layout are formatted. A pending count is
+     * reported from a background thread once the timeout passed, and by
+     * flush(), shutdown() and exit.
+     */
+    void collapse_repeats( const bool                      &p_collapse = true,
+                           const std::chrono::milliseconds &p_timeout  =
+                                 std::chrono::seconds(10) );
+
+
+    /**
+     * @brief Writes log output to a file instead of stdout/stderr.
+     * @param p_path File to append to, an empty path restores the streams.
+     * @throws std::runtime_error if the file can not be opened.
+     *
+     * Copies of a Logger share the same output.
+     */
+    void set_output_file( const std::string &p_path );
+
+
+    /**
+     * @brief Writes log output into a shared memory ring, for a Collector in
+     *        another process to write out.
+     * @param p_name     Name shared with the Collector, an empty one returns
+     *                   to the stdout/stderr or file output.
+     * @param p_capacity Bytes in the ring, rounded up to a power of two.
+     * @throws std::runtime_error if the ring can not be created.
+     *
+     * Each process maps its own ring, "/<name>.<pid>", and the child of a
+     * fork() creates one too. Logging threads only copy their record into
+     * it, without locks or I/O; records that do not fit are dropped.
+     *
+     * A ring is closed when it is replaced, its Logger is destroyed, or
+     * the process exits. Closing removes an empty ring. A ring that still
+     * holds records is left for a Collector, which removes it once
+     * drained; until one does, it stays in /dev/shm.
+     */
+    void set_shared_memory_output( const std::string &p_name,
+                                   const std::size_t &p_capacity = 1 << 20 );
+
+
+    /**
+     * @brief Writes the records of each thread to a file of its own, so
+     *        logging threads never share an output.
+     * @param p_prefix Segments are named "<prefix>.<pid>.<n>.seg", an empty
+     *                 prefix returns to the shared output.
+     * @throws std::runtime_error if the calling thread's segment can not be
+     *         opened; other threads drop their records instead.
+     *
+     * Records are framed with their timestamp and a per-segment sequence
+     * number, for merge_thread_outputs() to put back in order.
+     */
+    void set_thread_output( const std::string &p_prefix );
+
+
+    /**
+     * @brief Merges segments of set_thread_output() by timestamp, then
+     *        sequence number.
+     * @param p_paths  Segment files.
+     * @param p_output Where the records are written.
+     * @return The amount of records written.
+     * @throws std::runtime_error if a segment can not be read.
+     */
+    static auto merge_thread_outputs( const std::vector<std::string> &p_paths,
+                                      std::FILE *p_output ) -> std::size_t;
+
+
+    /**
+     * @brief Hands log output over to a background writer thread.
+     * @param p_async    True to enable the writer (default true).
+     * @param p_capacity Records that may be queued before new ones are
+     *                   dropped.
+     *
+     * Records stay synchronous while a writer that shutdown() gave up on
+     * is still running. A fork() waits up to 100 ms for the queue to
+     * drain, so the parent's earlier records come before the child's in a
+     * shared output; the parent writes the rest afterwards.
+     */
+    void set_async( const bool        &p_async    = true,
+                    const std::size_t &p_capacity = 8192 );
+
+
+    /**
+     * @brief Makes the background writer emit records in sequence order,
+     *        the order log() numbered them in ({6} of the log format).
+     * @param p_window Records held back to sort late arrivals in, 0 writes
+     *                 them in queue order (default).
+     *
+     * Once the queue runs dry, held back records wait at most half a
+     * millisecond for late ones. A record more than @p p_window places late,
+     * e.g. from a thread preempted between numbering and queueing it, is
+     * still written out of order.
+     */
+    void set_sequence_order( const std::size_t &p_window );
+
+
+    /**
+     * @brief Blocks until every queued record has been written out.
+     */
+    void flush( void );
+
+
+    /**
+     * @brief Drains the async queue, flushes the output and stops the writer
+     *        thread, giving up after @p p_timeout.
+     * @return False if the writer could not drain the queue in time; it is
+     *         then left to finish in the background.
+     *
+     * Later records are written synchronously until set_async() is called
+     * again. Every output still open at exit is shut down the same way,
+     * with a one second timeout, and so is every output before log<ERROR>
+     * aborts the process.
+     */
+    auto shutdown( const std::chrono::milliseconds &p_timeout =
+                         std::chrono::seconds(1) ) -> bool;
+
+
+    /**
+     * @brief Keeps the last records written through this Logger in memory,
+     *        for snapshot().
+     * @param p_capacity Records kept, 0 to stop keeping them (default 256).
+     */
+    void set_backtrace( const std::size_t &p_capacity = 256 );
+
+
+    /**
+     * @brief Flushes the output, then writes the backtrace records to a file.
+     * @param p_path File to create, or truncate.
+     * @throws std::runtime_error if the file can not be opened.
+     */
+    void snapshot( const std::string &p_path );
+
+
+    /**
+     * @brief Flushes and snapshots this Logger whenever @p p_signal arrives.
+     * @param p_signal Signal to handle, like SIGUSR1 or SIGUSR2.
+     * @param p_prefix Snapshots are written to "<prefix>-<date>-<time>.log".
+     * @throws std::runtime_error if the handler can not be installed.
+     *
+     * The handler only wakes a background thread, which does the work
+     * outside of signal context. A signal serves the Logger it was last
+     * registered with, and keeps its output open.
+     */
+    void snapshot_on_signal( const int         &p_signal,
+                             const std::string &p_prefix = "cci_logger" );
+
+
+    /**
+     * @brief Logs @p p_msg as it is, through async-signal-safe calls only,
+     *        for use in signal handlers.
+     * @param p_level Severity, checked against the threshold as usual.
+     * @param p_msg   Preformatted message, cut short past about 1 KiB.
+     *
+     * The record has a fixed "[<epoch seconds>.<ms> <level>]: <msg>" layout
+     * and is written straight to the output with write(2), skipping the
+     * async queue, the configuration and every filter.
+     */
+    void log_signal_safe( const LogLevel   &p_level,
+                          std::string_view  p_msg ) noexcept;
+
+
+    /**
+     * @brief Installs handlers for SIGSEGV, SIGBUS, SIGFPE, SIGILL and
+     *        SIGABRT that save what they can of this Logger, then re-raise
+     *        the signal.
+     * @throws std::runtime_error if a handler can not be installed.
+     *
+     * The handler writes out the records still queued for the async writer
+     * and logs the signal through log_signal_safe(). If the output is not
+     * stderr, it also replays the backtrace records there, for context next
+     * to the crash. State locked by a thread at the time of the crash is
+     * left alone.
+     */
+    void flush_on_crash( void );
+
+
+    /**
+     * @brief Sums the per-thread counters of this Logger and its copies.
+     * @return A snapshot of the counters; threads still logging may move
+     *         them on immediately after.
+     */
+    auto stats( void ) const -> Stats;
+
+
+    /**
+     * @brief Lists the call sites that logged the most bytes.
+     * @param p_count Maximum amount of call sites returned (default 10).
+     * @return Call sites sorted by bytes, then hits, descending.
+     */
+    static auto call_site_report( const std::size_t &p_count = 10 )
+        -> std::vector<CallSiteStats>;
+
+
+    /**
+     * @brief Prints call_site_report() to stderr when the process exits.
+     * @param p_count Maximum amount of call sites printed (default 10).
+     */
+    static void report_call_sites_at_exit( const std::size_t &p_count = 10 );
+
+
+    /**
+     * @brief Switches the matching call sites on or off, overriding the
+     *        threshold of every Logger they log through.
+     * @param p_filter  Sites to change; this also applies to sites that are
+     *                  first reached later on.
+     * @param p_enabled Whether the sites log regardless of level, or never.
+     * @return The amount of already known sites that matched.
+     *
+     * Later calls take precedence over earlier ones for the sites they
+     * match. An enabled site below the threshold costs a call site lookup
+     * per record; a disabled one a single branch after the lookup.
+     */
+    static auto set_call_sites( const CallSiteFilter &p_filter,
+                                const bool           &p_enabled )
+        -> std::size_t;
+
+
+    /** @brief Drops every set_call_sites() override. */
+    static void reset_call_sites( void );
+
+
+    /**
+     * @brief Rate limits every log<> call site with its own token bucket.
+     * @param p_per_second Records a call site may sustain per second,
+     *                     0 disables rate limiting.
+     * @param p_burst      Records a call site may emit back to back.
+     * @param p_summary    How often to report suppressed records, as a
+     *                     warning attributed to each suppressing call site.
+     *
+     * The check happens before any formatting, so suppressed records cost
+     * little more than a clock read. Each Logger reports the records it
+     * suppressed itself, from a background thread, and on flush(),
+     * shutdown() and exit.
+     */
+    static void set_rate_limit( const double                    &p_per_second,
+                                const uint32_t                  &p_burst = 10,
+                                const std::chrono::milliseconds &p_summary =
+                                      std::chrono::seconds(1) );
+
+
+    /**
+     * @brief Serves runtime commands on a Unix domain socket, from a
+     *        background thread.
+     * @param p_path Socket path, an existing file there is replaced.
+     * @throws std::runtime_error if the socket can not be set up.
+     *
+     * Commands are read one per line, each answered by "ok", "error: ..."
+     * or its output:
+     * - level <level> [name]    Sets a registry level, the root by default.
+     * - reset <name>            Makes a registry name inherit again.
+     * - enable|disable [file=<glob>] [function=<name>] [line=<n>]
+     *                  [level=<level>]
+     * - reset-sites             Drops every enable/disable override.
+     * - flush                   Flushes this Logger's output.
+     * - dump <path>             Writes a snapshot() of this Logger.
+     * - stats                   Prints the counters of this Logger.
+     * - report [count]          Prints the noisiest call sites.
+     *
+     * The channel only goes through the setters, so logging threads see
+     * nothing of it beyond configuration swaps. A process serves one
+     * channel at a time, which keeps this Logger's output open until
+     * stop_control(). Clients are served one after another, and one that
+     * sends nothing for 5 s is disconnected. The child of a fork()
+     * neither serves nor removes the parent's channel.
+     */
+    void serve_control( const std::string &p_path );
+
+
+    /** @brief Closes the control channel and removes its socket. */
+    static void stop_control( void );
+
+
     /**
      * @brief Logs a message at the specified log level.
      * @tparam T_Level LogLevel template parameter for severity.
@@ -90,45 +801,83 @@ public:
      * @param p_args Arguments to format the message.
      *
      * This function performs several steps:
+     * - Buffers the record if a RequestScope is active on this thread.
      * - Checks if the log level meets the threshold; ignores if not.
+     * - Keeps only a sample of the record's level, if configured.
+     * - Drops the record if its call site is over its rate limit.
      * - Retrieves current time and source location info.
-     * - Formats the message using the provided format string and args.
+     * - Formats the message using the provided format string and args,
+     *   writing common argument types without std::format.
+     * - Holds the record back if it repeats the previous one.
      * - Applies configured log message format, adding colours if enabled.
      * - Outputs the formatted message to stdout or stderr.
-     * - On error level, may prompt user to continue or abort execution.
+     * - On error level, applies the error policy, which may abort, or ask
+     *   the user whether to continue without blocking this thread.
      */
     template<LogLevel T_Level, typename... T_Args>
     void log( const FormatString &p_fmt,
               T_Args         &&...p_args )
     {
-        if (T_Level < m_threshold_level) return;
+        RequestScope *scope { RequestScope::s_current };
+        bool scoped { T_Level < WARN && scope != nullptr
+                   && T_Level >= scope->m_level };
+
+        if (scoped && !scope->m_failed) [[unlikely]] {
+            scope->defer(*this, T_Level, p_fmt,
+                         std::forward<T_Args>(p_args)...);
+            return;
+        }
+        if (T_Level == ERROR && scope != nullptr) scope->fail();
+
+        Counters &counters { get_counters() };
+        if (T_Level < threshold() && !scoped
+         && !is_forced(p_fmt.source, T_Level)) {
+            bump(counters.filtered);
+            return;
+        }
+
+        CallSite &site { find_call_site(p_fmt.source, T_Level) };
+        if (site.enabled.load(std::memory_order_relaxed) < 0) [[unlikely]] {
+            bump(counters.filtered);
+            return;
+        }
+
+        ConfigPin     pin    { *m_shared, counters };
+        const Config &config { *pin };
+
+        if (config.sampling[T_Level].active
+         && !sample(config.sampling[T_Level], T_Level)) {
+            bump(counters.sampled);
+            return;
+        }
 
-        std::string
-            time      { get_time() },
-            file      { p_fmt.source.file_name() },
-            function  { p_fmt.source.function_name() },
-            line      { std::to_string(p_fmt.source.line()) },
-            log_level { m_coloured ? m_LOG_LABELS[T_Level].first
-                                   : m_LOG_LABELS[T_Level].second },
-            msg  { std::vformat(p_fmt.fmt, std::make_format_args(p_args...)) };
+        if (s_rate_interval_ns.load(std::memory_order_relaxed) != 0)
+            if (!admit(site)) [[unlikely]] return;
 
-        function = function.substr(function.find_first_of(' ') + 1);
-        function = function.substr(0, function.find('('));
+        std::string msg { format_message(p_fmt.fmt, p_args...) };
+        if (config.collapse_repeats && is_repeat(config, T_Level, site, msg))
+            return;
 
-        std::string log_format { m_log_format };
-        if (m_log_format.empty())
-            log_format = m_coloured ? m_LOG_FORMATS.first
-                                    : m_LOG_FORMATS.second;
-        std::string full { format(log_format,
-                           time, log_level, function, file, line, msg) };
+        bump(counters.records[T_Level]);
+        uint64_t    sequence { next_sequence(config) };
+        auto        time     { record_time(config) };
+        std::string full { compose(config, T_Level, p_fmt.source.file_name(),
+                                   p_fmt.source.function_name(),
+                                   p_fmt.source.line(), msg, sequence,
+                                   time) };
 
-        print_log(full, T_Level >= WARN);
+        site.hits.fetch_add(1, std::memory_order_relaxed);
+        site.bytes.fetch_add(full.size(), std::memory_order_relaxed);
 
-        if (T_Level == ERROR && m_abort_on_err)
-            if (!ask_continue()) std::abort();
+        print_log(std::move(full), T_Level >= WARN, sequence, time);
+
+        if (T_Level == ERROR) handle_error(config, msg);
     }
 
 private:
+    /* Gives bench/ access to the individual formatting stages. */
+    friend struct LoggerProbe;
+
     using view_pair = std::pair<std::string_view, std::string_view>;
 
     static constexpr std::array<view_pair, __LOG_LEVEL_AMOUNT> m_LOG_LABELS {{
@@ -144,33 +893,468 @@ private:
     };
 
 
-    LogLevel m_threshold_level;
+    /** @brief A Sampling, prepared for the hot path. */
+    struct SamplePolicy
+    {
+        bool     active    { false };
+        uint32_t every     { 1 };
+        uint64_t threshold { 0 }; /* probability scaled to 2^32 */
+        uint64_t budget    { 0 };
+    };
+
+    /** @brief The arguments log formats are given, by index. */
+    enum Field : uint8_t
+    {
+        FIELD_TIME, FIELD_LEVEL, FIELD_FUNCTION, FIELD_FILE, FIELD_LINE,
+        FIELD_MESSAGE, FIELD_SEQUENCE, FIELD_THREAD_ID, FIELD_THREAD_NAME,
+        FIELD_PID, FIELD_UPTIME, FIELD_CPU
+    };
+
+    /**
+     * @brief Everything the setters change. A published Config is never
+     *        modified; setters publish an updated copy instead, so log()
+     *        reads a consistent snapshot without taking a lock.
+     */
+    struct Config
+    {
+        std::string time_format { "%M:%S.%MS" };
+        std::string log_format;
+        uint32_t    fields  { 0x3f }; /* bit per Field the format uses */
+        bool        ordered { false }; /* set_sequence_order() is on */
+        Clock       clock   { Clock::SYSTEM };
+
+        bool coloured         { true };
+        bool ask_continue     { true };
+        bool abort_on_err     { true };
+
+        ErrorPolicy error_policy;
+        bool collapse_repeats { false };
+
+        std::chrono::nanoseconds                     repeat_timeout { 0 };
+        std::array<SamplePolicy, __LOG_LEVEL_AMOUNT> sampling;
+    };
+
+    /**
+     * @brief What log() reads inline of the state a Logger shares with its
+     *        copies. The rest is in Backend, which extends it.
+     */
+    struct Shared
+    {
+        std::atomic<uint32_t>       refs   { 1 };
+        std::atomic<const Config *> config { nullptr };
+        uint64_t                    id     { 0 };
+    };
+    struct Backend;
+
+    /**
+     * @brief A threshold level: either a named registry entry, or one of the
+     *        fixed levels unnamed Loggers point at.
+     *
+     * The effective level is cached along with the registry generation it
+     * was resolved in. Setting any level bumps the generation, which makes
+     * every cache stale, so children pick up their parent's change.
+     */
+    struct LevelNode
+    {
+        std::atomic<uint64_t> cache  { 0 };  /* generation << 8 | level */
+        std::atomic<int32_t>  level  { -1 }; /* -1 inherits */
+        LevelNode            *parent { nullptr };
+        std::string           name;
+    };
+
+    static inline std::atomic<uint64_t> s_level_generation { 1 };
+
+    /* Numbers records across every Logger, in the order they are composed. */
+    static inline std::atomic<uint64_t> s_sequence { 0 };
+    static std::array<LevelNode, __LOG_LEVEL_AMOUNT> s_fixed_levels;
+
+    Shared    *m_shared;
+    LevelNode *m_level;
+
+
+    /** @brief Adopts a reference to @p p_shared the caller took. */
+    explicit Logger( Shared *p_shared );
+
+
+    /** @brief Returns the effective threshold level of this Logger. */
+    auto threshold( void ) const -> LogLevel
+    {
+        uint64_t cache { m_level->cache.load(std::memory_order_relaxed) };
+        if ((cache >> 8) != s_level_generation.load(std::memory_order_relaxed))
+            [[unlikely]] cache = resolve_level(*m_level);
+        return static_cast<LogLevel>(cache & 0xff);
+    }
+
+
+    /** @brief Walks up to the closest set level and caches it. */
+    static auto resolve_level( LevelNode &p_node ) -> uint64_t;
+
+
+    /**
+     * @brief Takes the next record sequence number, or 0 if neither the
+     *        format nor the writer of @p p_config use it.
+     */
+    static auto next_sequence( const Config &p_config ) -> uint64_t
+    {
+        if (!p_config.ordered && (p_config.fields >> FIELD_SEQUENCE & 1) == 0)
+            return 0;
+        return s_sequence.fetch_add(1, std::memory_order_relaxed);
+    }
+
+
+    /** @brief Returns the state shared with every copy of this Logger. */
+    auto backend( void ) const -> Backend &;
+
+
+    /**
+     * @brief Publishes a copy of the current configuration, changed by
+     *        @p p_update. Concurrent updates are serialised.
+     */
+    void update_config( const std::function<void( Config & )> &p_update );
+
+
+    /**
+     * @brief Counters owned by a single thread, padded so that threads never
+     *        share a cache line. Only the owner writes, stats() reads.
+     */
+    struct alignas(64) Counters
+    {
+        std::array<std::atomic<uint64_t>, __LOG_LEVEL_AMOUNT> records {};
+
+        std::atomic<uint64_t> filtered  { 0 };
+        std::atomic<uint64_t> bytes     { 0 };
+        std::atomic<uint64_t> dropped   { 0 };
+        std::atomic<uint64_t> limited   { 0 };
+        std::atomic<uint64_t> collapsed { 0 };
+        std::atomic<uint64_t> sampled   { 0 };
+        std::atomic<uint64_t> print_ns  { 0 };
+
+        /* The snapshot the owner reads, update_config() does not free it. */
+        std::atomic<const Config *> pinned { nullptr };
+        uint32_t                    pins   { 0 };
+    };
+
+    /* Zero-initialised, backend ids start at 1. */
+    struct CounterCache
+    {
+        uint64_t  backend_id;
+        Counters *counters;
+    };
+    static inline thread_local CounterCache s_counter_cache;
+
+
+    /** @brief Single-writer increment, cheaper than an atomic add. */
+    static void
+    bump( std::atomic<uint64_t> &p_counter, const uint64_t &p_by = 1 )
+    {
+        p_counter.store(p_counter.load(std::memory_order_relaxed) + p_by,
+                        std::memory_order_relaxed);
+    }
+
+
+    /** @brief Returns the calling thread's counters for this Logger. */
+    auto get_counters( void ) -> Counters &
+    {
+        if (s_counter_cache.backend_id != m_shared->id) [[unlikely]]
+            s_counter_cache = { m_shared->id, &attach_counters() };
+        return *s_counter_cache.counters;
+    }
+
+
+    /** @brief Finds or allocates the calling thread's counters. */
+    auto attach_counters( void ) -> Counters &;
+
+
+    /**
+     * @brief Keeps the current configuration snapshot from being freed for
+     *        as long as it lives. Pins of a thread nest, inner ones read the
+     *        snapshot of the outermost.
+     */
+    class ConfigPin
+    {
+    public:
+        ConfigPin( const Shared &p_shared, Counters &p_counters ) :
+            m_counters(p_counters)
+        {
+            if (m_counters.pins++ != 0) return;
+
+            /* Either update_config() sees the pin, or the snapshot is seen
+               to be replaced here and pinning starts over. */
+            const Config *config { p_shared.config.load() };
+            while (true) {
+                m_counters.pinned.store(config);
+
+                const Config *current { p_shared.config.load() };
+                if (current == config) break;
+                config = current;
+            }
+        }
+
+        ~ConfigPin( void )
+        {
+            if (--m_counters.pins == 0)
+                m_counters.pinned.store(nullptr, std::memory_order_release);
+        }
+
+        ConfigPin( const ConfigPin & ) = delete;
+        auto operator=( const ConfigPin & ) -> ConfigPin & = delete;
+
+        auto operator*( void ) const -> const Config &
+        { return *m_counters.pinned.load(std::memory_order_relaxed); }
+
+        auto operator->( void ) const -> const Config *
+        { return m_counters.pinned.load(std::memory_order_relaxed); }
+
+    private:
+        Counters &m_counters;
+    };
+
+
+    /** @brief Pins the current configuration snapshot. */
+    auto pin_config( void ) -> ConfigPin
+    { return { *m_shared, get_counters() }; }
+
+
+    /**
+     * @brief A log<> call site, identified by its source location. Sites live
+     *        in a fixed global table and are never removed.
+     */
+    struct CallSite
+    {
+        std::atomic<uint64_t> key   { 0 };
+        std::atomic<bool>     ready { false };
+
+        const char *file     { nullptr };
+        const char *function { nullptr };
+        uint32_t    line     { 0 };
+        uint32_t    column   { 0 };
+        LogLevel    level    { DEBUG };
+
+        std::atomic<uint64_t> hits  { 0 };
+        std::atomic<uint64_t> bytes { 0 };
+
+        /* set_call_sites() override: 1 on, -1 off, 0 follows the level. */
+        std::atomic<int8_t> enabled { 0 };
+
+        /* Rate limiting: theoretical arrival time of the next record. */
+        std::atomic<uint64_t> next_ns { 0 };
+    };
+
+
+    static constexpr std::size_t m_CALL_SITE_CAPACITY { 4096 };
+    static_assert(std::has_single_bit(m_CALL_SITE_CAPACITY));
+
+    static std::array<CallSite, m_CALL_SITE_CAPACITY> s_call_sites;
+    static CallSite                                   s_overflow_site;
 
-    std::string m_time_format;
-    std::string m_log_format;
 
-    bool m_coloured;
-    bool m_ask_continue;
-    bool m_abort_on_err;
+    /** @brief Hashes a source location, never to 0. */
+    static auto call_site_key( const char     *p_file,
+                               const uint32_t &p_line,
+                               const uint32_t &p_column ) -> uint64_t;
 
 
-    /** @brief Returns current time formatted as string */
-    auto get_time( void ) -> std::string;
+    /**
+     * @brief The table slot probing for @p p_key starts at: the high bits
+     *        of the multiplicative hash, which every input bit reaches.
+     */
+    static auto call_site_slot( const uint64_t &p_key ) -> std::size_t
+    {
+        return static_cast<std::size_t>(
+            p_key >> (64 - std::countr_zero(m_CALL_SITE_CAPACITY)));
+    }
+
+
+    /* Call sites switched on, below-threshold records look them up. */
+    static inline std::atomic<uint64_t> s_forced_sites { 0 };
+
+    static inline std::atomic<uint64_t> s_rate_interval_ns  { 0 };
+    static inline std::atomic<uint64_t> s_rate_tolerance_ns { 0 };
+    static inline std::atomic<uint64_t> s_rate_summary_ns   { 0 };
+    static inline std::atomic<uint64_t> s_next_summary_ns   { 0 };
+
+
+    /**
+     * @brief Looks up, or registers, the call site at @p p_source.
+     * @return The site, or a shared overflow site once the table is full.
+     */
+    static auto find_call_site( const std::source_location &p_source,
+                                const LogLevel             &p_level )
+        -> CallSite &;
+
+
+    /** @brief Whether a record below the threshold is switched on anyway. */
+    static auto is_forced( const std::source_location &p_source,
+                           const LogLevel             &p_level ) -> bool
+    {
+        return s_forced_sites.load(std::memory_order_relaxed) != 0
+            && find_call_site(p_source, p_level)
+                   .enabled.load(std::memory_order_relaxed) > 0;
+    }
+
+
+    /**
+     * @brief Applies the set_call_sites() overrides to a new site, and
+     *        publishes it. The caller holds the filter lock.
+     */
+    static void apply_call_site_filters( CallSite &p_site );
+
+
+    /** @brief Returns the given, or current, time formatted as string. */
+    auto get_time( const std::chrono::system_clock::time_point &p_time =
+                         std::chrono::system_clock::now() ) -> std::string;
+
+
+    /** @brief Reads the clock of @p p_config. */
+    static auto now( const Config &p_config )
+        -> std::chrono::system_clock::time_point;
+
+
+    /**
+     * @brief Reads the clock of @p p_config if the log format or the output
+     *        uses the time of a record, so both get the same one.
+     * @return The time, or a default time_point if neither uses it.
+     */
+    auto record_time( const Config &p_config )
+        -> std::chrono::system_clock::time_point;
+
+
+    /**
+     * @brief Applies the log format to an already formatted message.
+     * @param p_time When the record was logged, now() if not given.
+     * @return The full record, ready to be printed.
+     */
+    auto compose( const Config     &p_config,
+                  const LogLevel   &p_level,
+                  std::string_view  p_file,
+                  std::string_view  p_function,
+                  const uint32_t   &p_line,
+                  std::string_view  p_msg,
+                  const uint64_t   &p_sequence,
+                  const std::chrono::system_clock::time_point &p_time = {} )
+        -> std::string;
+
+
+    /**
+     * @brief Takes a token from the rate limit bucket of @p p_site, and
+     *        counts the record against this Logger if there is none.
+     * @return True if the record may be logged.
+     */
+    auto admit( CallSite &p_site ) -> bool;
+
+
+    /** @brief Prints and resets the suppressed record counts. */
+    void report_suppressed( void );
+
+
+    /**
+     * @brief Reports what every Logger holds back, suppressed records once
+     *        the summary interval passed and repeats once they timed out,
+     *        or all of it if @p p_final.
+     */
+    static void housekeep( const bool &p_final );
+
+
+    /** @brief Starts the thread running housekeep(), once. */
+    static void start_housekeeping( void );
+    static void run_housekeeping( void );
+    static void stop_housekeeping( void );
+
+
+    /**
+     * @brief Applies the sampling policy of @p p_level to one record.
+     * @return True if the record is kept.
+     */
+    auto sample( const SamplePolicy &p_policy,
+                 const LogLevel     &p_level ) -> bool;
+
+
+    /**
+     * @brief Checks @p p_msg against the previous record of its output, and
+     *        reports the end of a run of repeats.
+     * @return True if the record repeats the previous one.
+     */
+    auto is_repeat( const Config     &p_config,
+                    const LogLevel   &p_level,
+                    CallSite         &p_site,
+                    std::string_view  p_msg ) -> bool;
+
+
+    /**
+     * @brief Prints the pending "repeated N times" records of every output.
+     */
+    void flush_repeats( void );
+
+
+    /**
+     * @brief Prints the pending repeat counts held back for longer than the
+     *        repeat timeout.
+     */
+    void expire_repeats( void );
+
+
+    struct Repeats;
+
+    /**
+     * @brief Prints and resets the repeat count of @p p_last, if any.
+     *        The caller holds its lock.
+     */
+    void report_repeats( const Config &p_config, Repeats &p_last );
+
+
+    /** @brief The flush_on_crash() handler. */
+    static void on_crash_signal( int p_signal );
+
+
+    /**
+     * @brief The pthread_atfork() handlers: take every lock before fork(),
+     *        and let the child restart the threads it did not inherit.
+     */
+    static void before_fork( void );
+    static void after_fork_parent( void );
+    static void after_fork_child( void );
+
+
+    /**
+     * @brief Applies the error policy after an ERROR record was printed.
+     */
+    void handle_error( const Config &p_config, std::string_view p_msg );
+
+
+    /**
+     * @brief Shuts down every output, then aborts the process.
+     */
+    [[noreturn]] static void abort_flushed( void );
+
+
+    /**
+     * @brief Queues a prompt for the prompt thread, starting it if needed.
+     */
+    static void prompt_continue( void );
+    static void run_prompter( void );
 
 
     /**
      * @brief Prompts user whether to continue after error.
+     * @param p_errors Errors the answer covers.
      * @return True if user chooses to continue.
      */
-    auto ask_continue( void ) -> bool;
+    static auto ask_continue( const uint64_t &p_errors ) -> bool;
 
 
     /**
-     * @brief Prints the log message to stdout or stderr.
+     * @brief Prints the log message to the configured output.
      * @param p_msg The full formatted log message.
      * @param p_err True if message is an error (print to stderr).
+     * @param p_sequence The next_sequence() it was composed with.
+     * @param p_time The record_time() it was composed with, for outputs
+     *               that stamp records; read now if not given.
      */
-    void print_log( const std::string &p_msg, const bool &p_err );
+    void print_log( std::string     p_msg,
+                    const bool     &p_err,
+                    const uint64_t &p_sequence,
+                    const std::chrono::system_clock::time_point &p_time =
+                          {} );
 
 
     /**
@@ -181,8 +1365,124 @@ private:
      */
     template<typename... T_Args>
     auto format( std::string_view p_fmt, T_Args &&...p_args ) -> std::string
+    { return format_message(p_fmt, p_args...); }
+
+
+    /**
+     * @brief An argument format_fast() writes itself, without going
+     *        through std::format.
+     */
+    struct FastArg
+    {
+        enum Kind : uint8_t
+        { SIGNED, UNSIGNED, FLOAT, DOUBLE, BOOL, CHAR, STRING, POINTER };
+
+        Kind kind;
+        union
+        {
+            int64_t     i;
+            uint64_t    u;
+            float       f;
+            double      d;
+            bool        b;
+            char        c;
+            const void *p;
+        };
+        std::string_view text {};
+    };
+
+
+    /**
+     * @brief Whether format_fast() writes @p T as a string. Anything else
+     *        that converts to one, nullptr included, keeps its formatter.
+     */
+    template<typename T>
+    static constexpr bool is_fast_string {
+        std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+     || std::is_same_v<T, const char *> || std::is_same_v<T, char *>
+     || (std::is_array_v<T>
+      && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>) };
+
+
+    /**
+     * @brief Whether format_fast() can write a @p T argument. Wide
+     *        characters are left to std::format, which rejects them, and
+     *        long double to std::format, which keeps all of its digits.
+     */
+    template<typename T, typename T_Plain = std::remove_cvref_t<T>>
+    static constexpr bool is_fast_arg {
+        (std::is_arithmetic_v<T_Plain> && !std::is_same_v<T_Plain, wchar_t>
+      && !std::is_same_v<T_Plain, long double>
+      && !std::is_same_v<T_Plain, char8_t>
+      && !std::is_same_v<T_Plain, char16_t>
+      && !std::is_same_v<T_Plain, char32_t>)
+     || std::is_same_v<T_Plain, const void *>
+     || std::is_same_v<T_Plain, void *>
+     || is_fast_string<T_Plain> };
+
+
+    template<typename T>
+    static auto fast_arg( const T &p_arg ) -> FastArg
     {
-        return std::vformat(p_fmt, std::make_format_args(
-                                   std::forward<T_Args>(p_args)...));
+        using Kind = FastArg::Kind;
+        FastArg arg {};
+        arg.kind = Kind::STRING;
+
+        if constexpr (std::is_same_v<T, bool>) {
+            arg.kind = Kind::BOOL;
+            arg.b    = p_arg;
+        } else if constexpr (std::is_same_v<T, char>) {
+            arg.kind = Kind::CHAR;
+            arg.c    = p_arg;
+        } else if constexpr (std::is_same_v<T, float>) {
+            arg.kind = Kind::FLOAT;
+            arg.f    = p_arg;
+        } else if constexpr (std::is_same_v<T, double>) {
+            arg.kind = Kind::DOUBLE;
+            arg.d    = p_arg;
+        } else if constexpr (std::is_signed_v<T>) {
+            arg.kind = Kind::SIGNED;
+            arg.i    = p_arg;
+        } else if constexpr (std::is_unsigned_v<T>) {
+            arg.kind = Kind::UNSIGNED;
+            arg.u    = p_arg;
+        } else if constexpr (is_fast_string<T>) {
+            arg.text = p_arg;
+        } else {
+            arg.kind = Kind::POINTER;
+            arg.p    = p_arg;
+        }
+
+        return arg;
+    }
+
+
+    /**
+     * @brief Writes @p p_fmt with @p p_args to @p p_out, if it only has
+     *        "{}" or "{<index>}" replacement fields.
+     * @return False if std::format has to take over.
+     */
+    static auto format_fast( std::string_view  p_fmt,
+                             const FastArg    *p_args,
+                             const std::size_t &p_count,
+                             std::string       &p_out ) -> bool;
+
+
+    /**
+     * @brief std::vformat(), with integers, floats, pointers and strings
+     *        in plain replacement fields written by format_fast() instead.
+     */
+    template<typename... T_Args>
+    static auto format_message( std::string_view p_fmt,
+                                const T_Args &...p_args ) -> std::string
+    {
+        if constexpr ((is_fast_arg<T_Args> && ...)) {
+            const std::array<FastArg, sizeof...(T_Args)> args {
+                fast_arg(p_args)... };
+
+            std::string out;
+            if (format_fast(p_fmt, args.data(), args.size(), out)) return out;
+        }
+        return std::vformat(p_fmt, std::make_format_args(p_args...));
     }
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include <unordered_set>
+#include <cci_logger.hh>
+
+
+/** @brief Exposes the call site hash, as bench/ does its stages. */
+struct LoggerProbe
+{
+    static auto
+    slot( const char *p_file, const uint32_t &p_line,
+          const uint32_t &p_column ) -> std::size_t
+    {
+        return Logger::call_site_slot(
+            Logger::call_site_key(p_file, p_line, p_column));
+    }
+};
+
+
+/*
+ * Hashes the call sites of a long file that all sit at one column, then
+ * checks that they start probing from slots spread over the table.
+ */
+auto
+main( void ) -> int32_t
+{
+    constexpr uint32_t LINES { 2000 };
+
+    std::unordered_set<std::size_t> slots;
+    for (uint32_t line { 1 }; line <= LINES; line++)
+        slots.insert(LoggerProbe::slot(__FILE__, line, 9));
+
+    /* About 1600 of 4096 slots are expected, a single one was seen. */
+    return slots.size() > LINES / 2 ? 0 : 1;
+}
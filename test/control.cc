@@ -0,0 +1,130 @@
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include "util.hh"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+/*
+ * Sends each control command over its own connection and checks the reply
+ * and its effect on the output, then checks that a client which sends
+ * nothing is dropped instead of holding the channel.
+ */
+namespace
+{
+    auto
+    connect_to( const std::filesystem::path &p_socket ) -> int
+    {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::string path { p_socket.string() };
+        std::memcpy(address.sun_path, path.data(), path.size());
+
+        int fd { socket(AF_UNIX, SOCK_STREAM, 0) };
+        if (fd < 0) return -1;
+
+        /* Fail the test rather than hang it. */
+        timeval timeout { 20, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        if (connect(fd, reinterpret_cast<const sockaddr *>(&address),
+                    sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+
+    /** @brief Sends @p p_line, and returns everything until hang-up. */
+    auto
+    request( const std::filesystem::path &p_socket, std::string_view p_line )
+        -> std::string
+    {
+        int fd { connect_to(p_socket) };
+        if (fd < 0) return "";
+
+        std::string line { std::string(p_line) + '\n' };
+        if (write(fd, line.data(), line.size()) < 0) line.clear();
+        shutdown(fd, SHUT_WR);
+
+        std::array<char, 512> buffer;
+        std::string           reply;
+        ssize_t               size;
+        while ((size = read(fd, buffer.data(), buffer.size())) > 0)
+            reply.append(buffer.data(), static_cast<std::size_t>(size));
+
+        close(fd);
+        return reply;
+    }
+
+
+    void
+    chatter( Logger &p_logger, const int32_t &p_round )
+    { p_logger.log<DEBUG>("chatter {}", p_round); }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    std::filesystem::path dir { std::filesystem::temp_directory_path() };
+    TempLog log { std::format("cci_logger_control_{}.log", getpid()) };
+    std::filesystem::path socket {
+        dir / std::format("cci_logger_control_{}.sock", getpid()) };
+    std::filesystem::path dump {
+        dir / std::format("cci_logger_control_{}.dump", getpid()) };
+    std::filesystem::remove(dump);
+
+    int32_t status { 0 };
+    {
+        Logger root { Logger::get("") };
+        log.attach(root);
+        root.set_backtrace(4);
+        root.serve_control(socket.string());
+
+        Logger named { Logger::get("ctl") };
+        named.log<INFO>("hidden by the root level");
+        if (request(socket, "level info ctl") != "ok\n") status = 1;
+        named.log<INFO>("shown at info");
+        named.log<DEBUG>("hidden below info");
+
+        /* Filtered, so the site is first claimed by the enabled round. */
+        chatter(root, 0);
+        if (!request(socket, "enable file=control.cc level=debug")
+                 .starts_with("ok, 0 call sites matched")) status = 1;
+        chatter(root, 1);
+        if (!request(socket, "disable file=control.cc level=debug")
+                 .starts_with("ok, 1 call sites matched")) status = 1;
+        chatter(root, 2);
+        if (request(socket, "reset-sites") != "ok\n") status = 1;
+
+        if (!request(socket, "stats").starts_with("records   debug="))
+            status = 1;
+        if (request(socket, std::format("dump {}", dump.string()))
+                != "ok\n"
+         || !std::filesystem::exists(dump)) status = 1;
+        if (!request(socket, "level loud")
+                 .starts_with("error: unknown level loud")) status = 1;
+        if (!request(socket, "bogus").starts_with("error: invalid command"))
+            status = 1;
+
+        /* An idle client must not keep the next one waiting for good. */
+        int idle { connect_to(socket) };
+        if (idle < 0 || request(socket, "flush") != "ok\n") status = 1;
+        if (idle >= 0) close(idle);
+
+        Logger::stop_control();
+        Logger::reset_level("ctl");
+        root.flush();
+    }
+
+    if (log.lines() != "shown at info|chatter 1|") status = 1;
+
+    std::filesystem::remove(dump);
+    return status;
+}
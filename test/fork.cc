@@ -0,0 +1,98 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <cci_logger.hh>
+
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+
+/*
+ * Forks while an async writer has records queued, then logs from both
+ * processes. Each record must reach the shared file exactly once, the
+ * child must snapshot its own records on a signal, and its exit must leave
+ * the parent's control socket in place.
+ */
+namespace
+{
+    /** @brief Waits for a written snapshot starting with @p p_prefix. */
+    auto
+    find_snapshot( const std::filesystem::path &p_prefix )
+        -> std::filesystem::path
+    {
+        for (int32_t i { 0 }; i < 200; i++) {
+            for (const auto &entry : std::filesystem::directory_iterator {
+                     p_prefix.parent_path() })
+                if (entry.path().filename().string().starts_with(
+                        p_prefix.filename().string())
+                 && entry.file_size() != 0)
+                    return entry.path();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return {};
+    }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    constexpr int32_t RECORDS { 5000 };
+
+    std::filesystem::path dir { std::filesystem::temp_directory_path() };
+    std::filesystem::path path {
+        dir / std::format("cci_logger_fork_{}.log", getpid()) };
+    std::filesystem::path socket {
+        dir / std::format("cci_logger_fork_{}.sock", getpid()) };
+    std::filesystem::path prefix {
+        dir / std::format("cci_logger_fork_{}_child", getpid()) };
+    std::filesystem::remove(path);
+
+    Logger logger { DEBUG };
+    logger.set_coloured_log(false);
+    logger.set_output_file(path.string());
+    logger.set_async(true, 4 * RECORDS);
+    logger.set_backtrace(4);
+    logger.set_clock(Logger::Clock::TSC);
+    logger.serve_control(socket.string());
+    logger.snapshot_on_signal(SIGUSR1, prefix.string());
+
+    for (int32_t i { 0 }; i < RECORDS; i++) logger.log<INFO>("before {}", i);
+
+    pid_t pid { fork() };
+    if (pid < 0) return 1;
+
+    const char *side { pid == 0 ? "child" : "parent" };
+    for (int32_t i { 0 }; i < RECORDS; i++)
+        logger.log<INFO>("{} {}", side, i);
+
+    if (pid == 0) {
+        raise(SIGUSR1);
+        std::exit(find_snapshot(prefix).empty() ? 1 : 0);
+    }
+
+    int32_t status { 0 };
+    waitpid(pid, &status, 0);
+    logger.flush();
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return 1;
+    if (!std::filesystem::exists(socket)) return 1;
+    Logger::stop_control();
+
+    std::filesystem::path snapshot { find_snapshot(prefix) };
+    std::ifstream         records  { snapshot };
+    std::string           first;
+    std::getline(records, first);
+    std::filesystem::remove(snapshot);
+    if (first.find("child") == std::string::npos) return 1;
+
+    std::ifstream file { path };
+    std::string   line;
+    int32_t       lines { 0 };
+    while (std::getline(file, line)) lines++;
+
+    std::filesystem::remove(path);
+    return lines == 3 * RECORDS ? 0 : 1;
+}
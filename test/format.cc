@@ -0,0 +1,71 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <cci_logger.hh>
+
+
+/** @brief Exposes the fields a layout captures, as bench/ does its stages. */
+struct LoggerProbe
+{
+    Logger &logger;
+
+    auto fields( void ) -> uint32_t
+    { return logger.pin_config()->fields; }
+};
+
+
+/*
+ * Logs arguments of the types the formatter writes itself, then checks the
+ * output against what std::format makes of them, and which fields layouts
+ * with escaped braces, format specs and nested fields capture.
+ */
+auto
+main( void ) -> int32_t
+{
+    std::filesystem::path path {
+        std::filesystem::temp_directory_path() / "cci_logger_format.log" };
+    std::filesystem::remove(path);
+
+    {
+        Logger logger { DEBUG };
+        logger.set_log_format("{5}\n");
+        logger.set_output_file(path.string());
+
+        logger.log<INFO>("{} {} {} {}", -42, UINT64_MAX, 2.5, 0.1F);
+        logger.log<INFO>("{} {}", INT64_MIN, 1e100);
+        logger.log<INFO>("{1}-{0}", "a", std::string { "b" });
+        logger.log<INFO>("{{{}}} {} {}", true, 'x', std::string_view { "sv" });
+        logger.log<INFO>("{}", reinterpret_cast<const void *>(0x10));
+        logger.log<INFO>("{} {}", nullptr, 1.0L / 4);
+        logger.flush();
+    }
+
+    std::ifstream file { path };
+    std::string   line;
+    for (std::string_view expected : {
+             "-42 18446744073709551615 2.5 0.1",
+             "-9223372036854775808 1e+100",
+             "b-a",
+             "{true} x sv",
+             "0x10",
+             "0x0 0.25" })
+        if (!std::getline(file, line) || line != expected) return 1;
+
+    std::filesystem::remove(path);
+
+    Logger      logger { DEBUG };
+    LoggerProbe probe  { logger };
+    for (auto [layout, fields] : {
+             std::pair { "{5}\n",                            1U << 5 },
+             std::pair { "{{6}} {5}\n",                      1U << 5 },
+             std::pair { "}}{{7}} {{{8}}}\n",                1U << 8 },
+             std::pair { "{6} {7} {8} {9} {10:.3f} {11}\n",  0xfc0U  },
+             std::pair { "{5:>{11}} {{{{9}}}}\n",            0x820U  },
+             std::pair { "{} {:>4}\n",                       0x3U    },
+             std::pair { "{{}}\n",                           0x0U    } }) {
+        logger.set_log_format(layout);
+        if (probe.fields() != fields) return 1;
+    }
+
+    return 0;
+}
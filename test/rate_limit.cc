@@ -0,0 +1,53 @@
+#include <string>
+#include <thread>
+#include "util.hh"
+
+
+/*
+ * Runs two Loggers over the rate limit of one call site, then checks that
+ * the suppressed records are reported without another record, and each by
+ * the Logger that suppressed them.
+ */
+namespace
+{
+    void
+    storm( Logger &p_logger, const int32_t &p_records )
+    {
+        for (int32_t i { 0 }; i < p_records; i++)
+            p_logger.log<INFO>("record {}", i);
+    }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    TempLog first { "cci_logger_rate_1.log" };
+    TempLog second { "cci_logger_rate_2.log" };
+
+    int32_t status { 0 };
+    {
+        Logger one { DEBUG }, two { DEBUG };
+        first.attach(one);
+        second.attach(two);
+
+        Logger::set_rate_limit(1, 1, std::chrono::milliseconds(200));
+        storm(one, 10);
+        storm(two, 5);
+
+        /* The storm is over, the summaries still come. */
+        uint64_t bytes { one.stats().bytes };
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+        if (one.stats().bytes == bytes) status = 1;
+
+        one.flush();
+        two.flush();
+        Logger::set_rate_limit(0);
+    }
+
+    std::string suffix { " records over the rate limit of this call site|" };
+    if (first.lines() != "record 0|suppressed 9" + suffix) status = 1;
+    if (second.lines() != "suppressed 5" + suffix) status = 1;
+
+    return status;
+}
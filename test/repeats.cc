@@ -0,0 +1,40 @@
+#include <thread>
+#include "util.hh"
+
+
+/*
+ * Collapses a run of repeats that stops, then checks that its count is
+ * reported once the timeout passed, without another record.
+ */
+auto
+main( void ) -> int32_t
+{
+    TempLog log { "cci_logger_repeats.log" };
+
+    int32_t status { 0 };
+    {
+        Logger logger { DEBUG };
+        log.attach(logger);
+        logger.collapse_repeats(true, std::chrono::milliseconds(200));
+
+        for (int32_t i { 0 }; i < 5; i++) logger.log<INFO>("same");
+        for (int32_t i { 0 }; i < 4; i++) logger.log<INFO>("{}", i % 2);
+
+        for (int32_t i { 0 }; i < 3; i++) logger.log<INFO>("last");
+
+        uint64_t bytes { logger.stats().bytes };
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+        if (logger.stats().bytes == bytes) status = 1;
+
+        /* Collapsed repeats and their summaries are not records. */
+        if (logger.stats().records[INFO] != 6) status = 1;
+
+        logger.flush();
+    }
+
+    if (log.lines() != "same|last message repeated 4 times|0|1|0|1|"
+                            "last|last message repeated 2 times|")
+        status = 1;
+
+    return status;
+}
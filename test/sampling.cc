@@ -0,0 +1,60 @@
+#include <filesystem>
+#include <cci_logger.hh>
+
+
+/*
+ * Samples INFO records by count, by probability and by budget, and checks
+ * how many of them each policy kept.
+ */
+namespace
+{
+    auto
+    kept( Logger &p_logger, const Logger::Sampling &p_sampling,
+          const int32_t &p_records ) -> uint64_t
+    {
+        Logger::Stats before { p_logger.stats() };
+
+        p_logger.set_sampling(INFO, p_sampling);
+        for (int32_t i { 0 }; i < p_records; i++)
+            p_logger.log<INFO>("record {}", i);
+        p_logger.set_sampling(INFO);
+
+        Logger::Stats after { p_logger.stats() };
+        uint64_t records { after.records[INFO] - before.records[INFO] };
+
+        /* Each record is either sampled out or printed, never both. */
+        if (records + (after.sampled - before.sampled)
+                != static_cast<uint64_t>(p_records)) return 0;
+        return records;
+    }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    std::filesystem::path path {
+        std::filesystem::temp_directory_path() / "cci_logger_sampling.log" };
+
+    int32_t status { 0 };
+    {
+        Logger logger { DEBUG };
+        logger.set_output_file(path.string());
+
+        /* Every 10th record of this thread, exactly. */
+        if (kept(logger, { .every = 10 }, 1000) != 100) status = 1;
+
+        /* Six standard deviations either way. */
+        uint64_t half { kept(logger, { .probability = 0.5 }, 10000) };
+        if (half < 4700 || half > 5300) status = 1;
+
+        /* Well under a second of records: past the budget, the chance of
+           keeping one falls with the count, to about budget * (1 + ln 200)
+           kept in total. */
+        uint64_t budgeted { kept(logger, { .budget = 100 }, 20000) };
+        if (budgeted < 100 || budgeted > 1000) status = 1;
+    }
+
+    std::filesystem::remove(path);
+    return status;
+}
@@ -0,0 +1,55 @@
+#include <string>
+#include <thread>
+#include "util.hh"
+
+
+/*
+ * Buffers records in RequestScopes that succeed, fail on an ERROR, and run
+ * over their latency budget, then checks which records were printed.
+ */
+auto
+main( void ) -> int32_t
+{
+    TempLog log { "cci_logger_scope.log" };
+
+    {
+        Logger root { Logger::get("") };
+        log.attach(root);
+        root.abort_on_error(false);
+        root.ask_continue_on_error(false);
+        Logger::set_level("", WARN);
+
+        {
+            Logger::RequestScope scope;
+            Logger::get("scope.ok").log<DEBUG>("discarded");
+        }
+
+        {
+            Logger::RequestScope scope;
+            Logger::get("scope.failed").log<DEBUG>("kept {}", 1);
+            Logger::get("scope.failed").log<INFO>("kept {}", 2);
+            {
+                std::string gone { "a view" };
+                Logger::get("scope.failed")
+                    .log<DEBUG>("kept {}", std::string_view { gone });
+            }
+            /* Too large to keep inline, so formatted up front. */
+            Logger::get("scope.failed").log<DEBUG>("kept {}{}{}{}{}",
+                std::string("a"), std::string("b"), std::string("c"),
+                std::string("d"), std::string("e"));
+            Logger::get("scope.failed").log<ERROR>("failed");
+            Logger::get("scope.failed").log<DEBUG>("after");
+        }
+
+        {
+            Logger::RequestScope scope { std::chrono::milliseconds(1) };
+            Logger::get("scope.slow").log<DEBUG>("slow");
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        root.flush();
+    }
+
+    return log.lines() == "kept 1|kept 2|kept a view|kept abcde|"
+                          "failed|after|slow|" ? 0 : 1;
+}
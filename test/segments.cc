@@ -0,0 +1,117 @@
+#include <filesystem>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cci_logger.hh>
+
+
+/*
+ * Threads log into their own segments, which are merged back into one log.
+ * Every record must come out once, and each thread's records in order.
+ * A record's frame must carry the time it was composed with, and switching
+ * segments must close the ones left behind.
+ */
+namespace
+{
+    auto
+    open_files( void ) -> std::ptrdiff_t
+    {
+        std::error_code error;
+        return std::distance(std::filesystem::directory_iterator {
+                                 "/proc/self/fd", error },
+                             std::filesystem::directory_iterator {});
+    }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    constexpr int32_t THREADS { 4 };
+    constexpr int32_t RECORDS { 1000 };
+
+    namespace fs = std::filesystem;
+    fs::path dir { fs::temp_directory_path() / "cci_logger_segments_test" };
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    Logger logger { DEBUG };
+    logger.set_coloured_log(false);
+    logger.set_thread_output((dir / "test").string());
+
+    std::vector<std::thread> threads;
+    for (int32_t t { 0 }; t < THREADS; t++)
+        threads.emplace_back([&logger, t]
+        {
+            for (int32_t i { 0 }; i < RECORDS; i++)
+                logger.log<INFO>("{} {}", t, i);
+        });
+    for (std::thread &thread : threads) thread.join();
+    logger.flush();
+
+    std::vector<std::string> paths;
+    for (const auto &entry : fs::directory_iterator { dir })
+        paths.push_back(entry.path().string());
+    if (paths.size() != THREADS + 1) return 1;
+
+    std::FILE *output { std::tmpfile() };
+    if (output == nullptr) return 1;
+    if (Logger::merge_thread_outputs(paths, output) != THREADS * RECORDS)
+        return 1;
+
+    std::rewind(output);
+    std::vector<int32_t> next(THREADS, 0);
+    std::array<char, 256> line {};
+    while (std::fgets(line.data(), line.size(), output) != nullptr) {
+        const char *msg { std::strstr(line.data(), "]: ") };
+        int32_t thread { 0 }, record { 0 };
+
+        if (msg == nullptr
+         || std::sscanf(msg, "]: %d %d", &thread, &record) != 2
+         || thread < 0 || thread >= THREADS || record != next[thread])
+            return 1;
+        next[thread]++;
+    }
+
+    std::fclose(output);
+
+    logger.set_clock(Logger::Clock::TSC);
+    logger.set_time_format("%ENS");
+    logger.set_log_format("{0}\n");
+    logger.set_thread_output((dir / "stamp").string());
+    logger.log<INFO>("stamped");
+    logger.flush();
+
+    /* The frame: magic, time, sequence and size, then the text. */
+    int32_t stamped { 0 };
+    for (const auto &entry : fs::directory_iterator { dir }) {
+        if (!entry.path().filename().string().starts_with("stamp")) continue;
+        stamped++;
+
+        std::ifstream file { entry.path(), std::ios::binary };
+        std::array<char, 8> magic;
+        int64_t             time { 0 };
+        std::string         text;
+        file.read(magic.data(), magic.size());
+        file.read(reinterpret_cast<char *>(&time), sizeof(time));
+        file.ignore(16);
+        std::getline(file, text);
+        if (text != std::to_string(time)) return 1;
+    }
+    if (stamped != 1) return 1;
+
+    std::ptrdiff_t files { open_files() };
+    for (int32_t i { 0 }; i < 20; i++)
+        logger.set_thread_output((dir / std::format("toggle{}", i % 2))
+                                 .string());
+    if (open_files() > files) return 1;
+
+    logger.set_thread_output("");
+    fs::remove_all(dir);
+
+    for (int32_t count : next)
+        if (count != RECORDS) return 1;
+    return 0;
+}
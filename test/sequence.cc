@@ -0,0 +1,103 @@
+#include <filesystem>
+#include <cinttypes>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cci_logger.hh>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+
+/*
+ * Threads log through an async writer that orders records by sequence
+ * number. The output is a FIFO left full until every record is queued, so
+ * the writer is stuck on its first record while the others arrive in
+ * whatever order the threads queue them. Every number must come out once,
+ * in order, and each thread's records in the order it logged them.
+ */
+auto
+main( void ) -> int32_t
+{
+    constexpr int32_t THREADS { 8 };
+    constexpr int32_t RECORDS { 5000 };
+
+    std::filesystem::path path { std::filesystem::temp_directory_path()
+        / std::format("cci_logger_sequence.{}", getpid()) };
+    std::filesystem::remove(path);
+    if (mkfifo(path.c_str(), 0600) != 0) return 1;
+
+    int reader { open(path.c_str(), O_RDONLY | O_NONBLOCK) };
+    int filler { open(path.c_str(), O_WRONLY | O_NONBLOCK) };
+    if (reader < 0 || filler < 0) return 1;
+
+    std::string padding(4096, '\n');
+    while (write(filler, padding.data(), padding.size()) > 0) {}
+    close(filler);
+
+    std::string output;
+    {
+        Logger logger { DEBUG };
+        logger.set_log_format("{6} {5}\n");
+        logger.set_output_file(path.string());
+        logger.set_async(true, THREADS * RECORDS + 1);
+        logger.set_sequence_order(THREADS * RECORDS + 1);
+
+        /* Larger than the stdio buffer, so the writer blocks on it. */
+        logger.log<INFO>("{}", std::string(1 << 16, 'p'));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        std::vector<std::thread> threads;
+        for (int32_t t { 0 }; t < THREADS; t++)
+            threads.emplace_back([&logger, t]
+            {
+                for (int32_t i { 0 }; i < RECORDS; i++)
+                    logger.log<INFO>("{} {}", t, i);
+            });
+        for (std::thread &thread : threads) thread.join();
+
+        fcntl(reader, F_SETFL, 0);
+        std::thread drain { [&output, reader]
+        {
+            std::array<char, 1 << 16> buffer;
+            ssize_t size;
+            while ((size = read(reader, buffer.data(), buffer.size())) > 0)
+                output.append(buffer.data(), static_cast<size_t>(size));
+        } };
+
+        logger.flush();
+        logger.set_output_file("");
+        drain.join();
+    }
+    close(reader);
+    std::filesystem::remove(path);
+
+    std::vector<int32_t> next(THREADS, 0);
+    uint64_t last  { 0 };
+    int32_t  lines { 0 };
+
+    for (std::size_t start { 0 }, end; start < output.size();
+         start = end + 1) {
+        end = output.find('\n', start);
+        if (end == std::string::npos) return 1;
+
+        std::string line { output.substr(start, end - start) };
+        if (line.empty()) continue;
+
+        uint64_t sequence { 0 };
+        int32_t  thread { 0 }, record { 0 };
+        if (std::sscanf(line.c_str(), "%" SCNu64 " %d %d", &sequence, &thread,
+                        &record) == 3) {
+            if (sequence <= last || thread < 0 || thread >= THREADS
+             || record != next[thread])
+                return 1;
+            next[thread]++;
+            lines++;
+        } else if (line.find(" ppp") == std::string::npos) return 1;
+
+        last = sequence;
+    }
+
+    return lines == THREADS * RECORDS ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <cci_logger.hh>
+
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/*
+ * Forked processes log into their shared memory rings while a Collector
+ * drains them. One of them forks with its ring open, and exits before its
+ * child logs. Every record must come out once, and the rings of the exited
+ * processes must be gone. So must the rings this process closes: at once
+ * if they are empty, or once collected if not.
+ */
+namespace
+{
+    auto
+    rings_left( const std::string &p_name ) -> bool
+    {
+        for (const auto &entry : std::filesystem::directory_iterator {
+                 "/dev/shm" })
+            if (entry.path().filename().string().starts_with(p_name))
+                return true;
+        return false;
+    }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    constexpr int32_t RECORDS { 2000 };
+    std::string name { std::format("cci_logger_shm_test_{}", getpid()) };
+
+    std::string closed { std::format("cci_logger_shm_closed_{}", getpid()) };
+    {
+        Logger logger { DEBUG };
+        logger.set_shared_memory_output(closed);
+        logger.set_shared_memory_output(closed + "_replacing");
+    }
+    if (rings_left(closed)) return 1;
+
+    {
+        Logger logger { DEBUG };
+        logger.set_shared_memory_output(name);
+        logger.log<INFO>("closed with a record");
+        logger.set_shared_memory_output("");
+    }
+    if (!rings_left(name)) return 1;
+
+    Logger::Collector collector { name, std::chrono::milliseconds(0) };
+    std::FILE        *output { std::tmpfile() };
+    if (output == nullptr) return 1;
+
+    /* Reads end of file once every logging process has exited. */
+    std::array<int, 2> done {};
+    if (pipe(done.data()) != 0) return 1;
+    fcntl(done[0], F_SETFL, O_NONBLOCK);
+
+    std::array<pid_t, 3> children {};
+    for (std::size_t c { 0 }; c < children.size(); c++) {
+        children[c] = fork();
+        if (children[c] < 0) return 1;
+        if (children[c] > 0) continue;
+
+        close(done[0]);
+        Logger logger { DEBUG };
+        logger.set_coloured_log(false);
+        logger.set_shared_memory_output(name);
+
+        if (c == 2) {
+            pid_t parent     { getpid() };
+            pid_t grandchild { fork() };
+            if (grandchild != 0) _exit(grandchild < 0 ? 1 : 0);
+
+            /* Wait for the parent's ring to be collected. */
+            std::string ring { std::format("/dev/shm/{}.{}", name, parent) };
+            for (int32_t i { 0 }; i < 5000 && std::filesystem::exists(ring);
+                 i++)
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        for (int32_t i { 0 }; i < RECORDS; i++)
+            logger.log<INFO>("process {} record {}", getpid(), i);
+        _exit(0);
+    }
+    close(done[1]);
+
+    std::size_t written { 0 };
+    std::size_t exited  { 0 };
+    char        byte;
+    while (read(done[0], &byte, 1) != 0 || exited < children.size()) {
+        written += collector.poll(output);
+
+        int32_t status { 0 };
+        if (waitpid(-1, &status, WNOHANG) <= 0) continue;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return 1;
+        exited++;
+    }
+
+    /* The orphaned grandchild counts as running until init reaps it. */
+    for (int32_t i { 0 }; i < 5000 && rings_left(name); i++) {
+        written += collector.poll(output);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    written += collector.finish(output);
+    if (rings_left(name)) return 1;
+
+    std::fclose(output);
+    return written == children.size() * RECORDS + 1 ? 0 : 1;
+}
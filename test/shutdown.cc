@@ -0,0 +1,96 @@
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <string>
+#include <cci_logger.hh>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+/*
+ * Runs each termination path in a forked child that logs through an async
+ * writer to a file, and checks that no record was lost on the way out.
+ */
+namespace
+{
+    constexpr int32_t RECORDS { 10000 };
+
+
+    auto
+    count_lines( const std::filesystem::path &p_path ) -> int32_t
+    {
+        std::ifstream file { p_path };
+        std::string   line;
+        int32_t       lines { 0 };
+
+        while (std::getline(file, line)) lines++;
+        return lines;
+    }
+
+
+    /** @return The child's wait status, or -1 if it could not be forked. */
+    auto
+    run_child( const std::filesystem::path          &p_path,
+               const std::function<void( Logger & )> &p_exit ) -> int32_t
+    {
+        std::filesystem::remove(p_path);
+
+        pid_t pid { fork() };
+        if (pid < 0) return -1;
+
+        if (pid == 0) {
+            /* Leaked, so only the exit path under test can drain it. */
+            auto *logger { new Logger { DEBUG } };
+            logger->set_coloured_log(false);
+            logger->set_output_file(p_path.string());
+            logger->set_async(true, RECORDS + 16);
+            logger->abort_on_error(true);
+            logger->ask_continue_on_error(false);
+
+            for (int32_t i { 0 }; i < RECORDS; i++)
+                logger->log<INFO>("record {}", i);
+
+            p_exit(*logger);
+            _exit(0);
+        }
+
+        int32_t status { 0 };
+        waitpid(pid, &status, 0);
+        return status;
+    }
+}
+
+
+auto
+main( void ) -> int32_t
+{
+    std::filesystem::path path {
+        std::filesystem::temp_directory_path()
+        / std::format("cci_logger_shutdown_{}.log", getpid()) };
+
+    /* exit() without destroying the Logger. */
+    int32_t status { run_child(path, []( Logger & ) { std::exit(0); }) };
+    if (!WIFEXITED(status) || count_lines(path) != RECORDS) return 1;
+
+    /* An explicit shutdown, after which records are written directly. */
+    status = run_child(path, []( Logger &p_logger )
+    {
+        if (!p_logger.shutdown(std::chrono::seconds(5))) _exit(2);
+        p_logger.log<INFO>("after shutdown");
+        p_logger.flush();
+    });
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0
+     || count_lines(path) != RECORDS + 1)
+        return 1;
+
+    /* An ERROR that aborts. */
+    status = run_child(path, []( Logger &p_logger )
+    { p_logger.log<ERROR>("abort"); });
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT
+     || count_lines(path) != RECORDS + 1)
+        return 1;
+
+    std::filesystem::remove(path);
+    return 0;
+}
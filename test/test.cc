@@ -1,4 +1,26 @@
-#include <cci_logger.hh>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include "util.hh"
+
+
+/** @brief Exposes the time stages of a Logger, as bench/ does. */
+struct LoggerProbe
+{
+    Logger &logger;
+
+    auto time( const std::chrono::system_clock::time_point &p_time )
+        -> std::string
+    { return logger.get_time(p_time); }
+
+    auto record( const std::chrono::system_clock::time_point &p_time )
+        -> std::string
+    {
+        return logger.compose(*logger.pin_config(), INFO, "test.cc", "main",
+                              1, "message", 0, p_time);
+    }
+};
 
 
 auto
@@ -13,15 +35,68 @@ main( void ) -> int32_t
     logger.set_time_format("%H:%M:%S");
     logger.log<INFO>("Test time");
 
+    logger.set_time_format("%ISO %ES.%NS %EUS");
+    logger.log<INFO>("Test time tokens");
+
+    using namespace std::chrono;
+    LoggerProbe              probe { logger };
+    system_clock::time_point fixed { seconds(1614834367)     /* 05:06:07 */
+                                   + nanoseconds(12300) };
+
+    logger.set_time_format("%ES %EMS %EUS %ENS|%MS %US %NS");
+    if (probe.time(fixed) != "1614834367 1614834367000 1614834367000012 "
+                             "1614834367000012300|000 000012 000012300")
+        return 1;
+
+#ifndef _WIN32
+    /* Each zone at its own second, as conversions are cached per second. */
+    logger.set_time_format("%ISO");
+    logger.set_log_format("{0}\n");
+    for (auto [zone, second, expected] : {
+             std::tuple { "<+0530>-05:30", 1, "T10:36:08.000012+05:30\n" },
+             std::tuple { "<-0330>+03:30", 2, "T01:36:09.000012-03:30\n" },
+             std::tuple { "UTC0",          3, "T05:06:10.000012+00:00\n" } }) {
+        setenv("TZ", zone, 1);
+        tzset();
+        if (probe.record(fixed + seconds(second))
+                != std::format("2021-03-04{}", expected))
+            return 1;
+    }
+    unsetenv("TZ");
+    tzset();
+#endif
+
     logger.set_time_format();
     logger.set_log_format("[{0} {1} {2} {3}:{4}] >> {5}\n");
     logger.log<WARN>("Test log format {}", 1);
 
+    Logger::set_thread_name("main");
+    logger.set_log_format("[{7} {8} {9} {10:.3f} cpu {11} #{6}] {5}\n");
+    logger.log<INFO>("Test layout fields");
+
+    logger.set_clock(Logger::Clock::TSC);
+    logger.log<INFO>("Test TSC clock");
+    logger.set_clock();
+
     logger.set_log_format();
     logger.abort_on_error(false);
     logger.log<ERROR>("Test ERROR");
 
-    Logger other { INFO };
+    uint32_t errors { 0 };
+    logger.set_error_policy({
+        .callback = [&errors]( std::string_view ) { return ++errors > 0; } });
+    logger.log<ERROR>("Test error policy");
+    if (errors != 1) return 1;
+    logger.set_error_policy();
+
+    /* From here on the records go to files, and are checked there. */
+    TempLog copies { "cci_logger_test_copies.log" };
+    TempLog named  { "cci_logger_test_named.log" };
+
+    Logger other { INFO }, root { Logger::get("") };
+    copies.attach(logger);
+    copies.attach(other);
+    named.attach(root);
 
     other.log<DEBUG>("wont print");
 
@@ -30,5 +105,66 @@ main( void ) -> int32_t
     logger.log<DEBUG>("TEST LOGGER");
     other.log<DEBUG>("TEST OTHER");
 
+    static_assert(sizeof(Logger) <= 2 * sizeof(void *));
+    other.set_level(ERROR);
+    other.log<WARN>("wont print");
+
+    Logger::Stats stats { logger.stats() };
+    if (stats.records[DEBUG] != 3 || stats.records[ERROR] != 2) return 1;
+
+    /* The report ranks by bytes, which the longer coloured records win. */
+    uint32_t loop { __LINE__ + 1 };
+    for (int32_t i { 0 }; i < 3; i++) logger.log<DEBUG>("Test loop {}", i);
+    if (std::ranges::count_if(Logger::call_site_report(64),
+            [loop]( const Logger::CallSiteStats &p_site )
+            { return p_site.line == loop && p_site.hits == 3; }) != 1)
+        return 1;
+
+    Logger http { Logger::get("net.http") };
+    Logger::set_level("net", DEBUG);
+    http.log<DEBUG>("Test named");
+    Logger::set_level("net.http", INFO);
+    http.log<DEBUG>("wont print");
+    Logger::reset_level("net.http");
+    http.log<DEBUG>("Test named inherits");
+    Logger::reset_level("net");
+    http.log<DEBUG>("wont print");
+
+    logger.flush();
+    root.flush();
+    if (copies.lines() != "TEST LOGGER|TEST OTHER|Test loop 0|"
+                              "Test loop 1|Test loop 2|"
+     || named.lines() != "Test named|Test named inherits|")
+        return 1;
+
+    Logger::set_call_sites({ .file = "test.cc", .level = DEBUG }, true);
+    Logger::set_call_sites({ .function = "main", .line = __LINE__ + 3 }, false);
+    for (std::string_view state : { "set", "reset" }) {
+        http.log<DEBUG>("Test forced {}", state);
+        logger.log<WARN>("Test disabled {}", state);
+        Logger::reset_call_sites();
+    }
+
+    /* Each only while its override is set. */
+    logger.flush();
+    root.flush();
+    if (!copies.lines().ends_with("Test loop 2|Test disabled reset|")
+     || !named.lines().ends_with("|Test forced set|"))
+        return 1;
+
+    logger.set_backtrace(4);
+    logger.log<INFO>("Test backtrace");
+    logger.snapshot("cci_logger_test.snapshot");
+    logger.set_backtrace(0);
+
+    logger.log_signal_safe(WARN, "Test signal safe");
+    logger.log_signal_safe(WARN, std::string(2048, 'x'));
+    if (logger.stats().truncated != 1) return 1;
+
+#ifndef _WIN32
+    logger.serve_control("cci_logger_test.sock");
+    Logger::stop_control();
+#endif
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cci_logger.hh>
+
+
+/*
+ * Reconfigures a Logger while other threads log through it. Built with
+ * -fsanitize=thread, any unsynchronised access fails the test.
+ */
+auto
+main( void ) -> int32_t
+{
+    Logger logger { DEBUG };
+    logger.set_output_file("/dev/null");
+    logger.abort_on_error(false);
+
+    std::atomic<bool>        done { false };
+    std::vector<std::thread> threads;
+
+    for (int32_t t { 0 }; t < 4; t++) {
+        threads.emplace_back([&logger, &done, t]
+        {
+            for (int32_t i { 0 }; !done.load(); i++) {
+                logger.log<DEBUG>("thread {} debug {}", t, i);
+                logger.log<INFO>("thread {} info", t);
+                logger.log<WARN>("thread {} warn {}", t, i * 0.5);
+            }
+        });
+    }
+
+    for (int32_t i { 0 }; i < 200; i++) {
+        logger.set_time_format(i % 2 == 0 ? "%H:%M:%S" : "%M:%S.%MS");
+        logger.set_log_format("[{0} {1}] {5}\n");
+        logger.set_log_format();
+        logger.set_coloured_log(i % 2 == 0);
+        logger.ask_continue_on_error(i % 2 == 0);
+        logger.collapse_repeats(i % 3 == 0);
+        logger.set_sampling(DEBUG, { .every = 2, .probability = 0.5 });
+        logger.set_sampling(DEBUG);
+        logger.set_async(i % 4 < 2, 1024);
+    }
+
+    done.store(true);
+    for (std::thread &thread : threads) thread.join();
+
+    logger.flush();
+    return 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <cci_logger.hh>
+
+
+/*
+ * Helpers shared by the tests that check what reached a log file.
+ */
+
+/** @brief Returns the lines of @p p_path, each followed by a '|'. */
+inline auto
+read_lines( const std::filesystem::path &p_path ) -> std::string
+{
+    std::ifstream file { p_path };
+    std::string   line, lines;
+
+    while (std::getline(file, line)) lines += line + '|';
+    return lines;
+}
+
+
+/**
+ * @brief A log file in the temporary directory, removed when created and
+ *        when destroyed.
+ */
+struct TempLog
+{
+    std::filesystem::path path;
+
+
+    explicit TempLog( std::string_view p_name ) :
+        path(std::filesystem::temp_directory_path() / p_name)
+    { std::filesystem::remove(path); }
+
+    ~TempLog( void )
+    {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    TempLog( const TempLog & ) = delete;
+    auto operator=( const TempLog & ) -> TempLog & = delete;
+
+
+    /** @brief Makes @p p_logger write just the message of each record here. */
+    void
+    attach( Logger &p_logger ) const
+    {
+        p_logger.set_log_format("{5}\n");
+        p_logger.set_output_file(path.string());
+    }
+
+    auto
+    lines( void ) const -> std::string
+    { return read_lines(path); }
+};
@@ -0,0 +1,54 @@
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <cci_logger.hh>
+
+
+/*
+ * Writes out the records every process logging under one name puts in its
+ * shared memory ring, e.g. `cci_log_collector app app.log`, until stopped
+ * by SIGINT or SIGTERM.
+ */
+namespace
+{
+    volatile std::sig_atomic_t stopping { 0 };
+
+    void
+    stop( int )
+    { stopping = 1; }
+}
+
+
+auto
+main( int32_t p_argc, char **p_argv ) -> int32_t
+{
+    if (p_argc < 2 || p_argc > 3) {
+        std::cerr << "Usage: " << p_argv[0] << " <name> [output]\n";
+        return 2;
+    }
+
+    std::FILE *output { stdout };
+    if (p_argc == 3) {
+        output = std::fopen(p_argv[2], "a");
+        if (output == nullptr) {
+            std::cerr << "Failed to open " << p_argv[2] << ": "
+                      << std::strerror(errno) << '\n';
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT,  stop);
+    std::signal(SIGTERM, stop);
+
+    Logger::Collector collector { p_argv[1] };
+    while (stopping == 0)
+        if (collector.poll(output) == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    collector.finish(output);
+    if (output != stdout) std::fclose(output);
+    return 0;
+}
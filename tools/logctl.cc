@@ -0,0 +1,57 @@
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+/*
+ * Sends one command to a Logger::serve_control() socket and prints the
+ * reply, e.g. `cci_logctl /tmp/app.sock level debug net.http`.
+ */
+auto
+main( int32_t p_argc, char **p_argv ) -> int32_t
+{
+    if (p_argc < 3) {
+        std::cerr << "Usage: " << p_argv[0] << " <socket> <command...>\n";
+        return 2;
+    }
+
+    std::string command { p_argv[2] };
+    for (int32_t i { 3 }; i < p_argc; i++) (command += ' ') += p_argv[i];
+    command += '\n';
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, p_argv[1], sizeof(address.sun_path) - 1);
+
+    int fd { socket(AF_UNIX, SOCK_STREAM, 0) };
+    if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr *>(&address),
+                          sizeof(address)) != 0) {
+        std::cerr << "Failed to connect to " << p_argv[1] << ": "
+                  << std::strerror(errno) << '\n';
+        return 1;
+    }
+
+    if (write(fd, command.data(), command.size())
+        != static_cast<ssize_t>(command.size())) {
+        std::cerr << "Failed to send command: " << std::strerror(errno)
+                  << '\n';
+        return 1;
+    }
+    shutdown(fd, SHUT_WR);
+
+    std::string reply;
+    char        buffer[512];
+    ssize_t     size;
+    while ((size = read(fd, buffer, sizeof(buffer))) > 0)
+        reply.append(buffer, static_cast<std::size_t>(size));
+    close(fd);
+
+    std::cout << reply;
+    return reply.starts_with("error:") ? 1 : 0;
+}
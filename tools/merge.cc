@@ -0,0 +1,43 @@
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cci_logger.hh>
+
+
+/*
+ * Puts the segments written under Logger::set_thread_output() back into one
+ * log ordered by time, e.g. `cci_log_merge app.log app.*.seg`.
+ */
+auto
+main( int32_t p_argc, char **p_argv ) -> int32_t
+{
+    if (p_argc < 3) {
+        std::cerr << "Usage: " << p_argv[0] << " <output|-> <segment>...\n";
+        return 2;
+    }
+
+    std::FILE *output { stdout };
+    if (std::strcmp(p_argv[1], "-") != 0) {
+        output = std::fopen(p_argv[1], "w");
+        if (output == nullptr) {
+            std::cerr << "Failed to open " << p_argv[1] << ": "
+                      << std::strerror(errno) << '\n';
+            return 1;
+        }
+    }
+
+    std::vector<std::string> paths { p_argv + 2, p_argv + p_argc };
+    int32_t                  status { 0 };
+    try {
+        Logger::merge_thread_outputs(paths, output);
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << '\n';
+        status = 1;
+    }
+
+    if (output != stdout) std::fclose(output);
+    return status;
+}